@@ -35,17 +35,30 @@ public class MetricsLogger : ModuleRules
 			new string[]
 			{
 				"CoreUObject",
+				"DerivedDataCache",
 				"Engine",
 				"EngineSettings",
 				"RHI",
 				"Http",
 				"Projects",
+				"Sockets",
 				"UnrealEd"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
 		
 		
+		// HTTPServer is only needed for the stand-in InfluxDB endpoint in the automation tests, so it is left out
+		// wherever WITH_DEV_AUTOMATION_TESTS is off
+		bool bWithTestHttpServer = Target.bBuildDeveloperTools &&
+			(Target.bForceCompileDevelopmentAutomationTests ||
+			(Target.Configuration != UnrealTargetConfiguration.Shipping && Target.Configuration != UnrealTargetConfiguration.Test));
+		if (bWithTestHttpServer)
+		{
+			PrivateDependencyModuleNames.Add("HTTPServer");
+		}
+		PrivateDefinitions.Add("WITH_METRICS_TEST_HTTP_SERVER=" + (bWithTestHttpServer ? "1" : "0"));
+
 		DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{
@@ -0,0 +1,183 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CookPhaseTracker.h"
+#include "IMetricsLogger.h"
+#include "MetricsClock.h"
+#include "MetricsLoggerSettings.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+FCookPhaseTracker::FCookPhaseTracker(IMetricsLogger& logger): MetricsLogger(logger)
+{
+}
+
+FCookPhaseTracker::~FCookPhaseTracker()
+{
+	if (IsActive()) {
+		UPackage::PreSavePackageEvent.RemoveAll(this);
+		UPackage::PackageSavedEvent.RemoveAll(this);
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().RemoveAll(this);
+		FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+		FCoreUObjectDelegates::OnSyncLoadPackage.RemoveAll(this);
+	}
+}
+
+void FCookPhaseTracker::Begin(uint64 InCookSpanId)
+{
+	if (IsActive()) return;
+
+	CookSpanId = InCookSpanId;
+	for (PhaseStats& phase : Phases) {
+		phase = PhaseStats();
+		phase.spanId = MetricsLoggerUtils::NewSpanId();
+	}
+	SaveStart = 0;
+	GarbageCollectStart = 0;
+	PackagesLoaded = 0;
+
+	// Only bound for the duration of the cook so saves and collections outside of it cost nothing
+	UPackage::PreSavePackageEvent.AddRaw(this, &FCookPhaseTracker::OnPreSavePackage);
+	UPackage::PackageSavedEvent.AddRaw(this, &FCookPhaseTracker::OnPackageSaved);
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddRaw(this, &FCookPhaseTracker::OnPreGarbageCollect);
+	FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FCookPhaseTracker::OnPostGarbageCollect);
+	FCoreUObjectDelegates::OnSyncLoadPackage.AddRaw(this, &FCookPhaseTracker::OnSyncLoadPackage);
+}
+
+void FCookPhaseTracker::End(EventMetaData& CookEvent)
+{
+	if (!IsActive() || CookEvent.spanId != CookSpanId) return;
+
+	UPackage::PreSavePackageEvent.RemoveAll(this);
+	UPackage::PackageSavedEvent.RemoveAll(this);
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().RemoveAll(this);
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+	FCoreUObjectDelegates::OnSyncLoadPackage.RemoveAll(this);
+
+	for (int32 i = 0; i < (int32)EPhase::NUM; i++) {
+		const PhaseStats& phase = Phases[i];
+		if (phase.count == 0) continue;
+
+		// The span covers the first to the last occurrence, its duration is only the time spent in the phase.
+		// It starts at the same time as the first occurrence's span, so the span kinds are kept in separate series.
+		EventMetaData phaseEvent = EventMetaData();
+		phaseEvent.type = LogEventTypeEnum::PHASE;
+		phaseEvent.startTime = phase.firstStart;
+		phaseEvent.finishTime = phase.lastFinish;
+		phaseEvent.duration = phase.totalSeconds;
+		phaseEvent.success = CookEvent.success;
+		phaseEvent.spanId = phase.spanId;
+		phaseEvent.parentSpanId = CookSpanId;
+		phaseEvent.AddTag("phase", GetPhaseName((EPhase)i));
+		phaseEvent.AddTag("span_kind", TEXT("total"));
+		phaseEvent.AddField("phase_count", phase.count);
+		MetricsLogger.Log(phaseEvent);
+	}
+
+	CookEvent.AddField("packages_loaded", PackagesLoaded);
+	CookEvent.AddField("packages_saved", Phases[(int32)EPhase::PackageSave].count);
+	CookEvent.AddField("package_save_seconds", Phases[(int32)EPhase::PackageSave].totalSeconds);
+	CookEvent.AddField("garbage_collect_seconds", Phases[(int32)EPhase::GarbageCollect].totalSeconds);
+	CookEvent.AddField("shader_compile_seconds", Phases[(int32)EPhase::ShaderCompile].totalSeconds);
+
+	CookSpanId = 0;
+}
+
+uint64 FCookPhaseTracker::AddPhase(EPhase Phase, int64 StartTime, int64 FinishTime)
+{
+	if (!IsActive()) return 0;
+
+	Record(Phase, StartTime, FinishTime);
+	return Phases[(int32)Phase].spanId;
+}
+
+void FCookPhaseTracker::OnPreSavePackage(UPackage* Package)
+{
+	SaveStart = FMetricsClock::Now();
+}
+
+void FCookPhaseTracker::OnPackageSaved(const FString& Filename, UObject* Package)
+{
+	if (SaveStart != 0) {
+		Record(EPhase::PackageSave, SaveStart, FMetricsClock::Now());
+		SaveStart = 0;
+	}
+}
+
+void FCookPhaseTracker::OnPreGarbageCollect()
+{
+	GarbageCollectStart = FMetricsClock::Now();
+}
+
+void FCookPhaseTracker::OnPostGarbageCollect()
+{
+	if (GarbageCollectStart != 0) {
+		Record(EPhase::GarbageCollect, GarbageCollectStart, FMetricsClock::Now());
+		GarbageCollectStart = 0;
+	}
+}
+
+void FCookPhaseTracker::OnSyncLoadPackage(const FString& PackageName)
+{
+	// There is no notification for a load finishing, so loads are only counted
+	PackagesLoaded++;
+}
+
+void FCookPhaseTracker::Record(EPhase Phase, int64 StartTime, int64 FinishTime)
+{
+	PhaseStats& phase = Phases[(int32)Phase];
+	const double seconds = FMetricsClock::ToSeconds(FinishTime - StartTime);
+
+	phase.firstStart = phase.count == 0 ? StartTime : FMath::Min(phase.firstStart, StartTime);
+	phase.lastFinish = FMath::Max(phase.lastFinish, FinishTime);
+	phase.totalSeconds += seconds;
+	phase.count++;
+
+	// Shader compile sessions are logged by the monitor already
+	if (Phase == EPhase::ShaderCompile || seconds < GetDefault<UMetricsLoggerSettings>()->PhaseSpanMinDuration) return;
+
+	EventMetaData spanEvent = EventMetaData();
+	spanEvent.type = LogEventTypeEnum::PHASE;
+	spanEvent.startTime = StartTime;
+	spanEvent.finishTime = FinishTime;
+	spanEvent.duration = seconds;
+	spanEvent.success = true;
+	spanEvent.spanId = MetricsLoggerUtils::NewSpanId();
+	spanEvent.parentSpanId = phase.spanId;
+	spanEvent.AddTag("phase", GetPhaseName(Phase));
+	spanEvent.AddTag("span_kind", TEXT("occurrence"));
+
+	// Points with the same tags and timestamp overwrite each other, and the coarsest precision is a second, so
+	// occurrences starting within the same second are told apart by their order in it
+	const int64 startSecond = StartTime / FMetricsClock::FromSeconds(1.0);
+	phase.occurrenceIndex = startSecond == phase.occurrenceSecond ? phase.occurrenceIndex + 1 : 0;
+	phase.occurrenceSecond = startSecond;
+	spanEvent.AddTag("occurrence_index", *FString::FromInt(phase.occurrenceIndex));
+	MetricsLogger.Log(spanEvent);
+}
+
+const TCHAR* FCookPhaseTracker::GetPhaseName(EPhase Phase)
+{
+	switch (Phase) {
+		case EPhase::PackageSave:
+			return TEXT("package_save");
+		case EPhase::GarbageCollect:
+			return TEXT("garbage_collect");
+		case EPhase::ShaderCompile:
+			return TEXT("shader_compile");
+		default:
+			return TEXT("unknown");
+	}
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsModel.h"
+
+class IMetricsLogger;
+class UPackage;
+
+/**
+ * Breaks a cook down into the phases it spends its time in.
+ *
+ * While a cook is tracked, engine delegates are bound to time package saves and garbage collection, and the monitor
+ * reports shader compile sessions that overlap it. Each phase is logged as one phase_event span (span_kind=total)
+ * under the cook's span covering every occurrence of that phase, and occurrences that take longer than the configured
+ * minimum are also logged as their own span (span_kind=occurrence) under the phase span, so the cook can be rebuilt
+ * as a timeline.
+ */
+class FCookPhaseTracker
+{
+public:
+	enum class EPhase : uint8
+	{
+		PackageSave,
+		GarbageCollect,
+		ShaderCompile,
+		NUM
+	};
+
+	FCookPhaseTracker(IMetricsLogger& logger);
+	~FCookPhaseTracker();
+
+	void Begin(uint64 InCookSpanId);
+
+	// Logs the phase spans and adds the phase totals to the cook event, if it is the cook being tracked
+	void End(EventMetaData& CookEvent);
+
+	bool IsActive() const { return CookSpanId != 0; }
+
+	// Records a phase timed outside the tracker and returns the span its own event should be parented to
+	uint64 AddPhase(EPhase Phase, int64 StartTime, int64 FinishTime);
+
+private:
+	// Delegate handlers
+	void OnPreSavePackage(UPackage* Package);
+	void OnPackageSaved(const FString& Filename, UObject* Package);
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+	void OnSyncLoadPackage(const FString& PackageName);
+
+	// Adds an occurrence to the phase totals and logs it on its own if it took long enough
+	void Record(EPhase Phase, int64 StartTime, int64 FinishTime);
+
+	static const TCHAR* GetPhaseName(EPhase Phase);
+
+	// Logger for the phase spans
+	IMetricsLogger& MetricsLogger;
+
+	// Totals of every occurrence of a phase during the cook
+	struct PhaseStats {
+		uint64 spanId{ 0 };
+		int64 firstStart{ 0 };
+		int64 lastFinish{ 0 };
+		double totalSeconds{ 0.0 };
+		int32 count{ 0 };
+
+		// Second the last occurrence span started in, and how many came before it in that second
+		int64 occurrenceSecond{ 0 };
+		int32 occurrenceIndex{ 0 };
+	};
+	PhaseStats Phases[(int32)EPhase::NUM];
+
+	// Start of the save or garbage collection in progress, 0 if there is none
+	int64 SaveStart{ 0 };
+	int64 GarbageCollectStart{ 0 };
+
+	int32 PackagesLoaded{ 0 };
+	uint64 CookSpanId{ 0 };
+};
@@ -0,0 +1,165 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "EditorFrameRecorder.h"
+#include "Editor.h"
+#include "EditorModeManager.h"
+#include "Subsystems/AssetEditorSubsystem.h"
+
+#include "IMetricsLogger.h"
+#include "MetricsClock.h"
+#include "MetricsLoggerSettings.h"
+
+static const FName DEFAULT_EDITOR_MODE(TEXT("Default"));
+
+FEditorFrameRecorder::FEditorFrameRecorder(IMetricsLogger& InLogger)
+	: Logger(InLogger)
+	, CurrentEditorMode(DEFAULT_EDITOR_MODE)
+{
+	// Commandlets don't have frames anyone is waiting on
+	bEnabled = GIsEditor && !IsRunningCommandlet() && GetDefault<UMetricsLoggerSettings>()->EnableFrameCapture;
+	if (!bEnabled) return;
+
+	MaxHitches = FMath::Max(GetDefault<UMetricsLoggerSettings>()->MaxHitchesPerInterval, 0);
+	Hitches.Reserve(MaxHitches);
+	IntervalStart = FMetricsClock::Now();
+	NextFlushTime = FPlatformTime::Seconds() + GetDefault<UMetricsLoggerSettings>()->FrameSummaryInterval;
+
+	EditorModeHandle = GLevelEditorModeTools().OnEditorModeIDChanged().AddRaw(this, &FEditorFrameRecorder::OnEditorModeChanged);
+}
+
+FEditorFrameRecorder::~FEditorFrameRecorder()
+{
+	if (!bEnabled) return;
+
+	GLevelEditorModeTools().OnEditorModeIDChanged().Remove(EditorModeHandle);
+	Flush();
+}
+
+void FEditorFrameRecorder::Tick(float DeltaTime)
+{
+	if (!bEnabled) return;
+
+	if (!(GEditor && GEditor->ShouldThrottleCPUUsage())) {
+		FrameTimes.Record(DeltaTime);
+
+		if (DeltaTime >= GetDefault<UMetricsLoggerSettings>()->HitchThreshold) {
+			AddHitch(DeltaTime);
+		}
+	}
+
+	if (FPlatformTime::Seconds() >= NextFlushTime) {
+		Flush();
+	}
+}
+
+void FEditorFrameRecorder::AddHitch(double Duration)
+{
+	NumHitches++;
+	HitchSeconds += Duration;
+
+	// Once the list is full a hitch only gets in by pushing out a shorter one
+	int32 index = Hitches.Num();
+	if (Hitches.Num() >= MaxHitches) {
+		index = INDEX_NONE;
+		for (int32 i = 0; i < Hitches.Num(); i++) {
+			if (Hitches[i].Duration < Duration && (index == INDEX_NONE || Hitches[i].Duration < Hitches[index].Duration)) {
+				index = i;
+			}
+		}
+		if (index == INDEX_NONE) return;
+	}
+	else {
+		Hitches.AddDefaulted();
+	}
+
+	FHitch& hitch = Hitches[index];
+	hitch.FinishTime = FMetricsClock::Now();
+	hitch.Duration = Duration;
+	hitch.EditorMode = CurrentEditorMode;
+	hitch.AssetEditor = NAME_None;
+	hitch.Asset.Reset();
+
+	// The asset editor that was activated last is the one being worked in
+	UAssetEditorSubsystem* assetEditors = GEditor ? GEditor->GetEditorSubsystem<UAssetEditorSubsystem>() : nullptr;
+	if (assetEditors) {
+		double lastActivationTime = -1.0;
+		for (UObject* asset : assetEditors->GetAllEditedAssets()) {
+			IAssetEditorInstance* editor = assetEditors->FindEditorForAsset(asset, false);
+			if (editor && editor->GetLastActivationTime() > lastActivationTime) {
+				lastActivationTime = editor->GetLastActivationTime();
+				hitch.AssetEditor = editor->GetEditorName();
+				hitch.Asset = asset->GetPathName();
+			}
+		}
+	}
+}
+
+void FEditorFrameRecorder::OnEditorModeChanged(const FName& ModeId, bool bIsEntering)
+{
+	if (bIsEntering) {
+		CurrentEditorMode = ModeId;
+	}
+	else if (ModeId == CurrentEditorMode) {
+		CurrentEditorMode = DEFAULT_EDITOR_MODE;
+	}
+}
+
+void FEditorFrameRecorder::Flush()
+{
+	NextFlushTime = FPlatformTime::Seconds() + GetDefault<UMetricsLoggerSettings>()->FrameSummaryInterval;
+
+	const int64 now = FMetricsClock::Now();
+	const int64 intervalStart = IntervalStart;
+	IntervalStart = now;
+
+	if (FrameTimes.GetCount() > 0) {
+		EventMetaData summary;
+		summary.type = LogEventTypeEnum::SUMMARY;
+		summary.startTime = intervalStart;
+		summary.finishTime = now;
+		summary.duration = FMetricsClock::ToSeconds(now - intervalStart);
+		summary.success = true;
+		summary.AddTag("event_type", TEXT("editor_frame"));
+		summary.AddField("count", FrameTimes.GetCount());
+		summary.AddField("duration_min", FrameTimes.GetMin());
+		summary.AddField("duration_mean", FrameTimes.GetMean());
+		summary.AddField("duration_p50", FrameTimes.GetPercentile(50.0));
+		summary.AddField("duration_p90", FrameTimes.GetPercentile(90.0));
+		summary.AddField("duration_p99", FrameTimes.GetPercentile(99.0));
+		summary.AddField("duration_max", FrameTimes.GetMax());
+		summary.AddField("hitch_count", NumHitches);
+		summary.AddField("hitch_seconds", HitchSeconds);
+		Logger.Log(summary);
+	}
+
+	for (const FHitch& hitch : Hitches) {
+		EventMetaData data;
+		data.type = LogEventTypeEnum::HITCH;
+		data.finishTime = hitch.FinishTime;
+		data.duration = hitch.Duration;
+		data.startTime = hitch.FinishTime - FMetricsClock::FromSeconds(hitch.Duration);
+		data.success = true;
+		data.AddTag("editor_mode", *hitch.EditorMode.ToString());
+		data.AddTag("asset_editor", *hitch.AssetEditor.ToString());
+		data.AddTag("asset", *hitch.Asset);
+		Logger.Log(data);
+	}
+
+	FrameTimes.Reset();
+	Hitches.Reset();
+	NumHitches = 0;
+	HitchSeconds = 0.0;
+}
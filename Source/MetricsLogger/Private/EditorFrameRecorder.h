@@ -0,0 +1,74 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsHistogram.h"
+
+class IMetricsLogger;
+
+/**
+ * Records how smoothly the editor runs without keeping anything per frame.
+ *
+ * Frame times go into a histogram and only the worst hitches above HitchThreshold are kept, along with the editor mode
+ * and the asset being edited when they happened. Once per FrameSummaryInterval the histogram is logged as a
+ * summary_event for editor_frame and each kept hitch as a hitch_event. Frames the editor throttles while it is in the
+ * background are left out as they would read as hitches.
+ */
+class FEditorFrameRecorder
+{
+public:
+	FEditorFrameRecorder(IMetricsLogger& InLogger);
+	~FEditorFrameRecorder();
+
+	bool IsEnabled() const { return bEnabled; }
+
+	// Called every editor frame
+	void Tick(float DeltaTime);
+
+	// Logs everything recorded since the last flush
+	void Flush();
+
+private:
+	struct FHitch
+	{
+		int64 FinishTime;
+		double Duration;
+		FName EditorMode;
+		FName AssetEditor;
+		FString Asset;
+	};
+
+	void AddHitch(double Duration);
+	void OnEditorModeChanged(const FName& ModeId, bool bIsEntering);
+
+	IMetricsLogger& Logger;
+	bool bEnabled{ false };
+
+	FMetricsHistogram FrameTimes;
+	int64 IntervalStart{ 0 };
+	double NextFlushTime{ 0.0 };
+
+	// The worst hitches this interval, and how many there were in all
+	TArray<FHitch> Hitches;
+	int32 MaxHitches{ 0 };
+	int32 NumHitches{ 0 };
+	double HitchSeconds{ 0.0 };
+
+	// Editor mode entered last, kept up to date from the mode tools' notifications
+	FName CurrentEditorMode;
+	FDelegateHandle EditorModeHandle;
+};
@@ -0,0 +1,91 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "EditorStartupTracker.h"
+#include "Misc/CoreDelegates.h"
+
+#include "IMetricsLogger.h"
+#include "MetricsClock.h"
+#include "MetricsLoggerSettings.h"
+
+FEditorStartupTracker::FEditorStartupTracker(IMetricsLogger& InLogger)
+	: Logger(InLogger)
+{
+	// Only an interactive editor launch has a first frame to wait for
+	bPending = GIsEditor && !IsRunningCommandlet() && GetDefault<UMetricsLoggerSettings>()->EnableStartupTiming;
+	if (!bPending) return;
+
+	// The plugin is loaded at PostEngineInit, so constructing this marks the end of engine initialization
+	ModuleStartTime = FPlatformTime::Seconds();
+	InitCompleteHandle = FCoreDelegates::OnFEngineLoopInitComplete.AddRaw(this, &FEditorStartupTracker::OnEngineLoopInitComplete);
+}
+
+FEditorStartupTracker::~FEditorStartupTracker()
+{
+	FCoreDelegates::OnFEngineLoopInitComplete.Remove(InitCompleteHandle);
+}
+
+void FEditorStartupTracker::OnEngineLoopInitComplete()
+{
+	InitCompleteTime = FPlatformTime::Seconds();
+	FCoreDelegates::OnFEngineLoopInitComplete.Remove(InitCompleteHandle);
+	InitCompleteHandle.Reset();
+}
+
+void FEditorStartupTracker::Tick()
+{
+	if (!bPending || InitCompleteTime == 0.0) return;
+	bPending = false;
+
+	// Convert the phase boundaries to wall clock timestamps relative to now
+	const double nowSeconds = FPlatformTime::Seconds();
+	const int64 now = FMetricsClock::Now();
+	auto toTimestamp = [nowSeconds, now](double seconds) {
+		return now - FMetricsClock::FromSeconds(nowSeconds - seconds);
+	};
+	const int64 processStart = toTimestamp(GStartTime);
+	const int64 moduleStart = toTimestamp(ModuleStartTime);
+	const int64 initComplete = toTimestamp(InitCompleteTime);
+
+	EventMetaData startupEvent = EventMetaData();
+	startupEvent.type = LogEventTypeEnum::STARTUP;
+	startupEvent.startTime = processStart;
+	startupEvent.finishTime = now;
+	startupEvent.duration = nowSeconds - GStartTime;
+	startupEvent.success = true;
+	startupEvent.spanId = MetricsLoggerUtils::NewSpanId();
+	startupEvent.AddField("engine_init_seconds", ModuleStartTime - GStartTime);
+	startupEvent.AddField("post_engine_init_seconds", InitCompleteTime - ModuleStartTime);
+	startupEvent.AddField("first_frame_seconds", nowSeconds - InitCompleteTime);
+
+	LogPhase(TEXT("engine_init"), processStart, moduleStart, startupEvent.spanId);
+	LogPhase(TEXT("post_engine_init"), moduleStart, initComplete, startupEvent.spanId);
+	LogPhase(TEXT("first_frame"), initComplete, now, startupEvent.spanId);
+	Logger.Log(startupEvent);
+}
+
+void FEditorStartupTracker::LogPhase(const TCHAR* Name, int64 StartTime, int64 FinishTime, uint64 ParentSpanId)
+{
+	EventMetaData phaseEvent = EventMetaData();
+	phaseEvent.type = LogEventTypeEnum::PHASE;
+	phaseEvent.startTime = StartTime;
+	phaseEvent.finishTime = FinishTime;
+	phaseEvent.duration = FMetricsClock::ToSeconds(FinishTime - StartTime);
+	phaseEvent.success = true;
+	phaseEvent.spanId = MetricsLoggerUtils::NewSpanId();
+	phaseEvent.parentSpanId = ParentSpanId;
+	phaseEvent.AddTag("phase", Name);
+	Logger.Log(phaseEvent);
+}
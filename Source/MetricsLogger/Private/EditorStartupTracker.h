@@ -0,0 +1,52 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMetricsLogger;
+
+/**
+ * Times how long the editor takes to become usable after it is launched.
+ *
+ * The launch is split into three phases: process start to PostEngineInit (when this plugin is loaded), PostEngineInit
+ * to the end of the engine loop's initialization, and from there to the first editor frame. They are logged as a
+ * single startup_event with a phase_event span for each phase once the first frame has been ticked.
+ */
+class FEditorStartupTracker
+{
+public:
+	FEditorStartupTracker(IMetricsLogger& InLogger);
+	~FEditorStartupTracker();
+
+	// Whether the startup is still being timed
+	bool IsPending() const { return bPending; }
+
+	// Called every editor frame - the first one after the engine loop has initialized ends the startup
+	void Tick();
+
+private:
+	void OnEngineLoopInitComplete();
+	void LogPhase(const TCHAR* Name, int64 StartTime, int64 FinishTime, uint64 ParentSpanId);
+
+	IMetricsLogger& Logger;
+	bool bPending{ false };
+
+	// Phase boundaries in FPlatformTime::Seconds, the same clock as GStartTime
+	double ModuleStartTime{ 0.0 };
+	double InitCompleteTime{ 0.0 };
+
+	FDelegateHandle InitCompleteHandle;
+};
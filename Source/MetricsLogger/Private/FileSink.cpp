@@ -0,0 +1,187 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "FileSink.h"
+#include "HAL/PlatformFilemanager.h"
+#include "JsonLinesWriter.h"
+#include "MetricsLogCategory.h"
+
+// Precision of the timestamps in a line protocol segment, as it appears in the file name
+static const TCHAR* GetPrecisionSuffix(TimestampPrecision precision)
+{
+	switch (precision)
+	{
+		case TimestampPrecision::Milliseconds:
+			return TEXT("ms");
+		case TimestampPrecision::Microseconds:
+			return TEXT("us");
+		case TimestampPrecision::Nanoseconds:
+			return TEXT("ns");
+		default:
+			return TEXT("s");
+	}
+}
+
+static const TCHAR* const PART_EXTENSION = TEXT(".part");
+
+FFileSink::FFileSink(const FString& InDirectory)
+	: IMetricsSink(TEXT("File"), GetDefault<UMetricsLoggerSettings>()->SinkQueueCapacity, GetDefault<UMetricsLoggerSettings>()->FileBackpressure)
+	, Directory(InDirectory)
+	, Format(GetDefault<UMetricsLoggerSettings>()->FileFormat)
+{
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*Directory);
+	StartThread();
+}
+
+FFileSink::~FFileSink()
+{
+	StopThread();
+	CloseSegment();
+}
+
+void FFileSink::Write(const FMetricsBatch& Batch)
+{
+	const FMetricsSettingsRef settings = Settings.Get();
+
+	Serialize(Batch);
+
+	// Line protocol segments hold a single precision, the other formats always store nanoseconds
+	if (Segment) {
+		const bool bFull = SegmentSize > 0 && SegmentSize + Content->Num() > settings->FileSegmentMaxBytes;
+		const bool bExpired = FPlatformTime::Seconds() - SegmentOpenTime >= settings->FileSegmentMaxAge;
+		const bool bPrecisionChanged = Format == FileSinkFormat::LineProtocol && Batch.Precision != SegmentPrecision;
+		if (bFull || bExpired || bPrecisionChanged) {
+			CloseSegment();
+		}
+	}
+
+	if (!Segment) {
+		if (!OpenSegment(Batch.Precision)) return;
+
+		// Binary blocks refer to the file's string dictionary, which starts over with the new segment
+		if (Format == FileSinkFormat::Binary) {
+			Serialize(Batch);
+		}
+	}
+
+	if (Segment->Write(Content->GetData(), Content->Num())) {
+		SegmentSize += Content->Num();
+		bUnsynced = true;
+	}
+	else {
+		// Part of the batch may have been written, and binary blocks after it would refer to dictionary strings that
+		// never made it to the file, so the segment is closed and the next batch starts a new one
+		UE_LOG(MetricsLog, Error, TEXT("Could not write to %s - dropping batch and starting a new file."), *SegmentFilename);
+		CloseSegment();
+	}
+}
+
+void FFileSink::Serialize(const FMetricsBatch& Batch)
+{
+	switch (Format)
+	{
+		case FileSinkFormat::JsonLines:
+			Buffer.Reset();
+			FJsonLinesWriter::EncodeTags(Batch.Tags.IsValid() ? *Batch.Tags : FMetricsTags(), EncodedTags);
+			for (const EventMetaData& data : Batch.Events) {
+				FJsonLinesWriter::Write(data, EncodedTags, Buffer);
+			}
+			Content = &Buffer;
+			break;
+		case FileSinkFormat::Binary:
+			Buffer.Reset();
+			BinaryWriter.WriteBlock(Batch, Buffer);
+			Content = &Buffer;
+			break;
+		default:
+			// Already serialized by the pipeline
+			Content = &Batch.LineProtocol;
+	}
+}
+
+void FFileSink::Update()
+{
+	if (bUnsynced && FPlatformTime::Seconds() >= NextSyncTime) {
+		Sync();
+	}
+}
+
+void FFileSink::OnFlush()
+{
+	if (bUnsynced) {
+		Sync();
+	}
+}
+
+bool FFileSink::OpenSegment(TimestampPrecision precision)
+{
+	FString extension;
+	switch (Format)
+	{
+		case FileSinkFormat::JsonLines:
+			extension = TEXT("jsonl");
+			break;
+		case FileSinkFormat::Binary:
+			extension = TEXT("mbin");
+			break;
+		default:
+			extension = FString::Printf(TEXT("%s.lp"), GetPrecisionSuffix(precision));
+	}
+	SegmentFilename = Directory / FString::Printf(TEXT("Metrics-%s-%d.%s"), *FDateTime::Now().ToString(), SegmentIndex++, *extension);
+
+	Segment.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*(SegmentFilename + PART_EXTENSION)));
+	if (!Segment) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not open %s - dropping batch."), *SegmentFilename);
+		return false;
+	}
+
+	SegmentPrecision = precision;
+	SegmentSize = 0;
+
+	// Binary files start with a header and a fresh string dictionary
+	if (Format == FileSinkFormat::Binary) {
+		TArray<uint8> header;
+		MetricsBinaryFormat::WriteFileHeader(header);
+		BinaryWriter.Reset();
+		if (Segment->Write(header.GetData(), header.Num())) {
+			SegmentSize += header.Num();
+		}
+	}
+	SegmentOpenTime = FPlatformTime::Seconds();
+	NextSyncTime = SegmentOpenTime + Settings->FileSyncInterval;
+	return true;
+}
+
+void FFileSink::CloseSegment()
+{
+	if (!Segment) return;
+
+	Sync();
+	Segment.Reset();
+
+	if (!FPlatformFileManager::Get().GetPlatformFile().MoveFile(*SegmentFilename, *(SegmentFilename + PART_EXTENSION))) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not finalize %s."), *SegmentFilename);
+	}
+}
+
+void FFileSink::Sync()
+{
+	if (Segment && !Segment->Flush(true)) {
+		UE_LOG(MetricsLog, Warning, TEXT("Could not sync %s to disk."), *SegmentFilename);
+	}
+
+	bUnsynced = false;
+	NextSyncTime = FPlatformTime::Seconds() + Settings->FileSyncInterval;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Parent Class
+#include "IMetricsSink.h"
+#include "MetricsBinaryFormat.h"
+#include "MetricsSettingsSnapshot.h"
+
+class IFileHandle;
+
+/**
+ * Sink that appends batches to files, for machines where metrics are archived rather than sent.
+ *
+ * Batches are written to a segment file that is rotated once it reaches a size or age limit. Open segments carry a
+ * .part extension that is dropped when they are closed, so anything picking the files up only sees complete ones.
+ * Writes go through the OS file cache and are only synced to disk every few seconds and on flush, so a burst of
+ * batches costs one sync rather than one each.
+ */
+class FFileSink: public IMetricsSink
+{
+public:
+	FFileSink(const FString& InDirectory);
+	virtual ~FFileSink();
+
+protected:
+	// IMetricsSink overrides
+	virtual void Write(const FMetricsBatch& Batch) override;
+	virtual void Update() override;
+	virtual void OnFlush() override;
+
+private:
+	// Points Content at the batch in the sink's format
+	void Serialize(const FMetricsBatch& Batch);
+
+	bool OpenSegment(TimestampPrecision precision);
+	void CloseSegment();
+	void Sync();
+
+	FString Directory;
+	FileSinkFormat Format;
+
+	// Rotation and sync limits for the sink thread
+	FMetricsSettingsCache Settings;
+
+	// Segment being appended to
+	TUniquePtr<IFileHandle> Segment;
+	FString SegmentFilename;
+	TimestampPrecision SegmentPrecision{ TimestampPrecision::Seconds };
+	int64 SegmentSize{ 0 };
+	double SegmentOpenTime{ 0.0 };
+	int32 SegmentIndex{ 0 };
+
+	// Bytes written since the last sync
+	bool bUnsynced{ false };
+	double NextSyncTime{ 0.0 };
+
+	// JSON Lines or binary serialization of the current batch - kept around to avoid reallocating it
+	TArray<uint8> Buffer;
+	TArray<uint8> EncodedTags;
+	FMetricsBinaryWriter BinaryWriter;
+	const TArray<uint8>* Content{ nullptr };
+};
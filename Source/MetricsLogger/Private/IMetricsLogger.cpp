@@ -24,12 +24,14 @@
 #include "PluginDescriptor.h"
 #include "Interfaces/IPluginManager.h"
 
+#include "Async/Async.h"
+
 /**
  * Base class for defining a class that can log metric information.
  */
 IMetricsLogger::IMetricsLogger() 
 {
-	// Grab Static Metadata Once
+	// Grab Static Metadata Once - these are cheap lookups that aren't safe to make off the game thread
 	ExtensionVersion = FString("unkown");
 	TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin("MetricsLogger");
 	if (Plugin.IsValid()) {
@@ -37,12 +39,18 @@ IMetricsLogger::IMetricsLogger()
 		ExtensionVersion = Descriptor.VersionName;
 	}
 	ProjectName = FApp::GetProjectName();
-	CoreCount = FString::FromInt(FPlatformMisc::NumberOfCores());
-	CpuModel = FPlatformMisc::GetCPUBrand();
-	RamSize = FString::Printf(TEXT("%llu"), FPlatformMemory::GetStats().TotalPhysical); // Use FString::Printf to format into Bytes
-	GpuModel = FPlatformMisc::GetPrimaryGPUBrand();
-	Username = FPlatformProcess::UserName(false);
-	Username = Username.Replace(TEXT(" "), TEXT("\\ "));
-	MachineName = FPlatformProcess::ComputerName();
 	UnrealVersion = FEngineVersion::Current().ToString();
+
+	// The hardware and account queries go to the OS and would add to every editor launch,
+	// so they run in the background and are only waited for when the first point is serialized
+	MachineInfo = Async(EAsyncExecution::ThreadPool, []() {
+		FMetricsMachineInfo info;
+		info.CoreCount = FString::FromInt(FPlatformMisc::NumberOfCores());
+		info.CpuModel = FPlatformMisc::GetCPUBrand();
+		info.RamSize = FString::Printf(TEXT("%llu"), FPlatformMemory::GetStats().TotalPhysical); // Use FString::Printf to format into Bytes
+		info.GpuModel = FPlatformMisc::GetPrimaryGPUBrand();
+		info.Username = FPlatformProcess::UserName(false);
+		info.MachineName = FPlatformProcess::ComputerName();
+		return info;
+		});
 }
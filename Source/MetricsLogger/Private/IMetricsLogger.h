@@ -15,10 +15,24 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "Async/Future.h"
 
 #include "MetricsLogCategory.h"
 #include "MetricsModel.h"
 
+/**
+ * Metadata about the machine that takes a noticeable time to query, so it is gathered on a background task.
+ */
+struct FMetricsMachineInfo
+{
+	FString CpuModel;
+	FString CoreCount;
+	FString RamSize;
+	FString GpuModel;
+	FString Username;
+	FString MachineName;
+};
+
 /**
  * Base class for defining a class that can log metric information.
  */
@@ -30,16 +44,22 @@ public:
 
 	virtual void Log(const EventMetaData& data) = 0;
 
+	// Forces any buffered data to be written out
+	virtual void Flush() {}
+
 protected:
 
+	// Waits for the machine metadata if the background task hasn't finished yet
+	const FMetricsMachineInfo& GetMachineInfo() const
+	{
+		return MachineInfo.Get();
+	}
+
 	// Meta Data
 	FString ExtensionVersion;
 	FString ProjectName;
 	FString UnrealVersion;
-	FString CpuModel;
-	FString CoreCount;
-	FString RamSize;
-	FString GpuModel;
-	FString Username;
-	FString MachineName;
+
+private:
+	TFuture<FMetricsMachineInfo> MachineInfo;
 };
@@ -0,0 +1,155 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "IMetricsSink.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "MetricsLogCategory.h"
+#include "MetricsSelfStats.h"
+
+// Longest a sink thread sleeps before giving the sink a chance to do periodic work
+const uint32 SINK_WAIT_MS = 250;
+
+IMetricsSink::IMetricsSink(const TCHAR* InName, int32 InQueueCapacity, SinkBackpressure InBackpressure)
+	: Name(InName)
+	, QueueCapacity(FMath::Max(InQueueCapacity, 1))
+	, Backpressure(InBackpressure)
+{
+	Queue.Reserve(QueueCapacity);
+	WriteBatches.Reserve(QueueCapacity);
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+IMetricsSink::~IMetricsSink()
+{
+	check(!Thread);
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void IMetricsSink::StartThread()
+{
+	Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("MetricsSink%s"), *Name), 0, TPri_BelowNormal);
+}
+
+void IMetricsSink::StopThread()
+{
+	if (Thread) {
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+void IMetricsSink::Submit(const FMetricsBatchRef& Batch)
+{
+	{
+		FScopeLock ScopeLock(&QueueLock);
+
+		if (Queue.Num() >= QueueCapacity) {
+			DroppedBatches.fetch_add(1, std::memory_order_relaxed);
+			FMetricsSelfStats::Add(FMetricsSelfStats::Get().BatchesDropped);
+			if (Backpressure == SinkBackpressure::DropNewest) return;
+
+			Queue.RemoveAt(0, 1, false);
+		}
+		Queue.Add(Batch);
+	}
+
+	WakeEvent->Trigger();
+}
+
+void IMetricsSink::Flush()
+{
+	bFlushRequested = true;
+	WakeEvent->Trigger();
+}
+
+uint32 IMetricsSink::Run()
+{
+	while (!bStopping) {
+		WakeEvent->Wait(SINK_WAIT_MS);
+
+		WriteQueued();
+
+		if (bFlushRequested.exchange(false)) {
+			OnFlush();
+		}
+
+		Update();
+	}
+
+	// Write out everything still queued before the thread exits
+	WriteQueued();
+	OnFlush();
+
+	return 0;
+}
+
+void IMetricsSink::Stop()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+}
+
+void IMetricsSink::WriteQueued()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(MetricsSink_WriteQueued);
+
+	const uint32 dropped = DroppedBatches.exchange(0, std::memory_order_relaxed);
+	if (dropped > 0) {
+		UE_LOG(MetricsLog, Warning, TEXT("%s sink could not keep up - dropped %u batches."), *Name, dropped);
+	}
+
+	// Take the whole queue so producers aren't held up while the batches are written. The empty array it is swapped
+	// with becomes the new queue.
+	{
+		FScopeLock ScopeLock(&QueueLock);
+		Swap(WriteBatches, Queue);
+	}
+
+	int32 numWritten = 0;
+	for (; numWritten < WriteBatches.Num(); numWritten++) {
+		if (!bStopping && !IsReady()) break;
+		Write(*WriteBatches[numWritten]);
+	}
+	if (numWritten == WriteBatches.Num()) {
+		WriteBatches.Reset();
+		return;
+	}
+
+	// Batches the sink wasn't ready for go back in front of any that arrived in the meantime
+	FScopeLock ScopeLock(&QueueLock);
+	WriteBatches.RemoveAt(0, numWritten, false);
+	WriteBatches.Append(Queue);
+	Swap(WriteBatches, Queue);
+	WriteBatches.Reset();
+
+	// The backpressure policy applies to the combined queue too
+	const int32 excess = Queue.Num() - QueueCapacity;
+	if (excess > 0) {
+		DroppedBatches.fetch_add(excess, std::memory_order_relaxed);
+		FMetricsSelfStats::Add(FMetricsSelfStats::Get().BatchesDropped, (uint64)excess);
+		if (Backpressure == SinkBackpressure::DropNewest) {
+			Queue.RemoveAt(QueueCapacity, excess, false);
+		}
+		else {
+			Queue.RemoveAt(0, excess, false);
+		}
+	}
+}
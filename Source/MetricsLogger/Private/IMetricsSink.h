@@ -0,0 +1,95 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+
+#include "MetricsBatch.h"
+#include "MetricsLoggerSettings.h"
+
+#include <atomic>
+
+/**
+ * Base class for a destination that batches from the logger pipeline are written to.
+ *
+ * Each sink has its own bounded queue and thread, so a slow or unreachable backend only ever backs up its own queue.
+ * Once the queue is full the sink's backpressure policy decides whether the new batch or the oldest queued one is
+ * dropped - the pipeline and the other sinks are never held up. A sink that can't take more work for a while (such as
+ * one waiting on its backend) leaves batches in the queue by returning false from IsReady().
+ *
+ * Derived classes must call StopThread() in their destructor so the thread is done with them before they go away.
+ */
+class IMetricsSink: public FRunnable
+{
+public:
+	IMetricsSink(const TCHAR* InName, int32 InQueueCapacity, SinkBackpressure InBackpressure);
+	virtual ~IMetricsSink();
+
+	// Queues a batch for the sink thread. Never blocks.
+	void Submit(const FMetricsBatchRef& Batch);
+
+	// Asks the sink to write out anything it is holding on to
+	void Flush();
+
+	const FString& GetName() const { return Name; }
+
+	// FRunnable overrides
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+protected:
+	// Starts the sink thread - called by derived constructors once they are fully set up
+	void StartThread();
+
+	// Stops the sink thread after it has written out every queued batch
+	void StopThread();
+
+	// Called on the sink thread for each batch
+	virtual void Write(const FMetricsBatch& Batch) = 0;
+
+	// Called on the sink thread before each batch - queued batches are held back while this is false.
+	// Everything is written regardless once the sink is stopping.
+	virtual bool IsReady() const { return true; }
+
+	// Called on the sink thread periodically and after each round of batches
+	virtual void Update() {}
+
+	// Called on the sink thread when a flush was requested, and before it exits
+	virtual void OnFlush() {}
+
+	bool IsStopping() const { return bStopping; }
+
+private:
+	void WriteQueued();
+
+	FString Name;
+
+	// Batches waiting for the sink thread
+	FCriticalSection QueueLock;
+	TArray<FMetricsBatchRef> Queue;
+	int32 QueueCapacity;
+
+	// Batches the sink thread is writing. Swapped with Queue each time round, so both keep their allocation.
+	TArray<FMetricsBatchRef> WriteBatches;
+	SinkBackpressure Backpressure;
+	std::atomic<uint32> DroppedBatches{ 0 };
+
+	// Sink thread and the event used to wake it early
+	FRunnableThread* Thread{ nullptr };
+	FEvent* WakeEvent{ nullptr };
+	std::atomic<bool> bStopping{ false };
+	std::atomic<bool> bFlushRequested{ false };
+};
@@ -0,0 +1,304 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "InfluxDBSink.h"
+#include "Http.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "MetricsLogCategory.h"
+#include "MetricsLoggerSettings.h"
+#include "MetricsSelfStats.h"
+
+static FString GetSpoolFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("MetricsLogger") / TEXT("Spool.dat");
+}
+
+static bool CompressGzip(const TArray<uint8>& content, TArray<uint8>& compressed)
+{
+	int32 compressedSize = FCompression::CompressMemoryBound(NAME_Gzip, content.Num());
+	compressed.SetNumUninitialized(compressedSize);
+
+	if (!FCompression::CompressMemory(NAME_Gzip, compressed.GetData(), compressedSize, content.GetData(), content.Num())) {
+		return false;
+	}
+
+	compressed.SetNum(compressedSize, false);
+	return true;
+}
+
+
+FInfluxDBSink::FSendState::FSendState(const FString& SpoolFilename, const FMetricsSettingsSnapshot& Settings)
+	: Spool(SpoolFilename, Settings.SpoolMaxBytes)
+	, Retry(Settings.RetryMinDelay, Settings.RetryMaxDelay, Settings.CircuitBreakerThreshold, Settings.CircuitBreakerOpenDuration)
+{
+}
+
+FInfluxDBSink::FInfluxDBSink()
+	: IMetricsSink(TEXT("InfluxDB"), GetDefault<UMetricsLoggerSettings>()->SinkQueueCapacity, GetDefault<UMetricsLoggerSettings>()->InfluxBackpressure)
+	, State(MakeShared<FSendState, ESPMode::ThreadSafe>(GetSpoolFilename(), *FMetricsSettings::Get()))
+	, MaxInFlight(FMath::Max(GetDefault<UMetricsLoggerSettings>()->InfluxMaxInFlightRequests, 1))
+{
+	StartThread();
+}
+
+FInfluxDBSink::FInfluxDBSink(const FMetricsSettingsRef& InSettings, const FString& InSpoolFilename)
+	: IMetricsSink(TEXT("InfluxDB"), GetDefault<UMetricsLoggerSettings>()->SinkQueueCapacity, GetDefault<UMetricsLoggerSettings>()->InfluxBackpressure)
+	, Settings(InSettings)
+	, State(MakeShared<FSendState, ESPMode::ThreadSafe>(InSpoolFilename, *InSettings))
+	, MaxInFlight(FMath::Max(GetDefault<UMetricsLoggerSettings>()->InfluxMaxInFlightRequests, 1))
+{
+	StartThread();
+}
+
+FInfluxDBSink::~FInfluxDBSink()
+{
+	StopThread();
+	CancelInFlight();
+}
+
+void FInfluxDBSink::Write(const FMetricsBatch& Batch)
+{
+	// A batch that just failed has to be in the spool before this one can tell whether to queue up behind it
+	ProcessCompletions();
+
+	// While older batches are waiting in the spool new ones queue up behind them so they are delivered in order.
+	// Batches still queued at shutdown go there too as there is no time left to send them, and so does everything
+	// while the circuit is open.
+	bool bOpen;
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		bOpen = State->Retry.IsOpen();
+	}
+
+	if (IsStopping() || bOpen || !State->Spool.IsEmpty()) {
+		State->Spool.Append(Batch.LineProtocol.GetData(), Batch.LineProtocol.Num(), (uint32)Batch.Precision);
+	}
+	else if (!SendLog(TArray<uint8>(Batch.LineProtocol), Batch.Precision, false, 0)) {
+		// A request that couldn't be started is retried from the spool - without an endpoint there is nowhere to send it
+		if (Settings->bInfluxConfigured) {
+			State->Spool.Append(Batch.LineProtocol.GetData(), Batch.LineProtocol.Num(), (uint32)Batch.Precision);
+		}
+		else {
+			UE_LOG(MetricsLog, Warning, TEXT("InfluxDB is not configured - dropping batch of %d bytes."), Batch.LineProtocol.Num());
+			FMetricsSelfStats::Add(FMetricsSelfStats::Get().BatchesDropped);
+		}
+	}
+}
+
+bool FInfluxDBSink::IsReady() const
+{
+	// Completed requests count until the sink thread has dealt with them
+	FScopeLock ScopeLock(&State->Lock);
+	return State->InFlight.Num() + State->Completed.Num() < MaxInFlight;
+}
+
+void FInfluxDBSink::Update()
+{
+	ProcessCompletions();
+	if (!IsStopping()) {
+		ReplaySpool();
+	}
+}
+
+void FInfluxDBSink::ReplaySpool()
+{
+	if (State->Spool.IsEmpty()) return;
+
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		if (State->bReplayInFlight || State->InFlight.Num() + State->Completed.Num() >= MaxInFlight || !State->Retry.CanAttempt()) return;
+	}
+
+	TArray<uint8> content;
+	uint32 precision;
+	uint64 sequence;
+	if (State->Spool.Peek(content, precision, &sequence)) {
+		SendLog(MoveTemp(content), (TimestampPrecision)precision, true, sequence);
+	}
+}
+
+bool FInfluxDBSink::SendLog(TArray<uint8>&& content, TimestampPrecision precision, bool bReplay, uint64 spoolSequence)
+{
+	// The URL for the configured version of InfluxDB was resolved when the settings last changed
+	const FMetricsSettingsRef settings = Settings.Get();
+	if (!settings->bInfluxConfigured) return false;
+	const FString& writeUrl = settings->GetInfluxWriteUrl(precision);
+
+	UE_LOG(MetricsLog, Log, TEXT("Logging %d bytes to %s"), content.Num(), *writeUrl);
+
+	// Construct the request. The HTTP module keeps connections to the endpoint open between requests, and with only a
+	// few requests in flight at a time they are reused rather than a new one being opened for every batch.
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> request = FHttpModule::Get().CreateRequest();
+	request->SetURL(writeUrl);
+	request->SetVerb("POST");
+	request->SetHeader(TEXT("Content-Type"), TEXT("text/plain; charset=utf-8"));
+	request->SetHeader(TEXT("Connection"), TEXT("keep-alive"));
+	request->SetTimeout(settings->InfluxRequestTimeout);
+
+	if (!settings->InfluxAuthorization.IsEmpty()) {
+		request->SetHeader(TEXT("Authorization"), settings->InfluxAuthorization);
+	}
+
+	// Both write endpoints accept gzip bodies - small batches aren't worth the CPU time
+	TArray<uint8> compressed;
+	if (settings->CompressRequests && content.Num() >= settings->CompressionMinBytes && CompressGzip(content, compressed)) {
+		request->SetHeader(TEXT("Content-Encoding"), TEXT("gzip"));
+		request->SetContent(compressed);
+	}
+	else {
+		request->SetContent(content);
+	}
+
+	// The callback can run after the sink is destroyed, so it only holds on to the send state weakly
+	TWeakPtr<FSendState, ESPMode::ThreadSafe> weakState = State;
+	request->OnProcessRequestComplete().BindLambda([weakState](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful) {
+		OnLogSendComplete(weakState.Pin(), Request, Response, bWasSuccessful);
+		});
+
+	// Registered before the request starts so the callback always finds it
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		State->InFlight.Add({ request, MoveTemp(content), precision, bReplay, spoolSequence, FPlatformTime::Seconds() });
+		State->bReplayInFlight |= bReplay;
+	}
+
+	if (!request->ProcessRequest()) {
+		FScopeLock ScopeLock(&State->Lock);
+		State->InFlight.RemoveAll([&request](const FSendState::FRequest& inFlight) { return inFlight.Request.Get() == &request.Get(); });
+		State->bReplayInFlight &= !bReplay;
+		return false;
+	}
+
+	FMetricsSelfStats& selfStats = FMetricsSelfStats::Get();
+	FMetricsSelfStats::Add(selfStats.RequestsSent);
+	FMetricsSelfStats::Add(selfStats.BytesSent, (uint64)request->GetContentLength());
+	return true;
+}
+
+void FInfluxDBSink::OnLogSendComplete(const FSendStatePtr& State, const FHttpRequestPtr& Request, const FHttpResponsePtr& Response, bool bWasSuccessful)
+{
+	if (!State.IsValid()) return;
+
+	FSendState::FCompletion completion;
+	completion.ResponseCode = Response.IsValid() ? Response->GetResponseCode() : 0;
+	completion.Result = FMetricsRetryPolicy::Classify(bWasSuccessful, completion.ResponseCode);
+
+	// Rate limited and overloaded servers usually say how long to stay away
+	completion.RetryAfter = Response.IsValid() ? FMetricsRetryPolicy::ParseRetryAfter(Response->GetHeader(TEXT("Retry-After"))) : -1.0;
+	if (completion.Result != EMetricsSendResult::Success && Response.IsValid()) {
+		completion.ResponseContent = Response->GetContentAsString();
+	}
+
+	FScopeLock ScopeLock(&State->Lock);
+
+	// Requests still in flight at shutdown were already spooled
+	if (State->bClosed) return;
+
+	const int32 index = State->InFlight.IndexOfByPredicate([&Request](const FSendState::FRequest& inFlight) { return inFlight.Request.Get() == Request.Get(); });
+	if (index == INDEX_NONE) return;
+
+	completion.Request = MoveTemp(State->InFlight[index]);
+	State->InFlight.RemoveAtSwap(index, 1, false);
+
+	FMetricsSelfStats& selfStats = FMetricsSelfStats::Get();
+	FMetricsSelfStats::Add(selfStats.RequestsCompleted);
+	FMetricsSelfStats::Add(selfStats.SendLatencyMicroseconds, (uint64)((FPlatformTime::Seconds() - completion.Request.StartTime) * 1000000.0));
+	if (completion.Result != EMetricsSendResult::Success) {
+		FMetricsSelfStats::Add(selfStats.RequestsFailed);
+	}
+
+	// Picked up within SINK_WAIT_MS by the sink thread's next Update
+	State->Completed.Add(MoveTemp(completion));
+}
+
+void FInfluxDBSink::ProcessCompletions()
+{
+	TArray<FSendState::FCompletion> completed;
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		if (State->Completed.Num() == 0) return;
+		Swap(completed, State->Completed);
+	}
+
+	for (FSendState::FCompletion& completion : completed) {
+		const FSendState::FRequest& request = completion.Request;
+
+		if (completion.Result == EMetricsSendResult::Success) {
+			UE_LOG(MetricsLog, Log, TEXT("Log submitted successfully!"));
+
+			if (request.bReplay) {
+				State->Spool.Pop(request.SpoolSequence);
+			}
+
+			FScopeLock ScopeLock(&State->Lock);
+			State->Retry.OnSuccess();
+		}
+		else {
+			UE_LOG(MetricsLog, Error, TEXT("Submitting log failed with return code: %d"), completion.ResponseCode);
+			if (!completion.ResponseContent.IsEmpty()) {
+				UE_LOG(MetricsLog, Error, TEXT("Return content is: %s"), *completion.ResponseContent);
+			}
+
+			if (completion.Result == EMetricsSendResult::Rejected) {
+				if (request.bReplay) {
+					State->Spool.Pop(request.SpoolSequence);
+				}
+			}
+			else {
+				if (!request.bReplay) {
+					State->Spool.Append(request.Content.GetData(), request.Content.Num(), (uint32)request.Precision);
+				}
+
+				FScopeLock ScopeLock(&State->Lock);
+				State->Retry.OnFailure(completion.RetryAfter);
+			}
+		}
+
+		// Only now that the spool head is dealt with can the next replay go out
+		if (request.bReplay) {
+			FScopeLock ScopeLock(&State->Lock);
+			State->bReplayInFlight = false;
+		}
+	}
+}
+
+void FInfluxDBSink::CancelInFlight()
+{
+	TArray<FSendState::FRequest> inFlight;
+	{
+		FScopeLock ScopeLock(&State->Lock);
+		State->bClosed = true;
+		Swap(inFlight, State->InFlight);
+	}
+
+	// The sink thread has stopped, so whatever completed since its last round is dealt with here
+	ProcessCompletions();
+
+	// Replays are still at the head of the spool. Anything else goes to the spool to be sent next time - if the
+	// request did get through before it was cancelled InfluxDB just overwrites the points with the same values.
+	for (FSendState::FRequest& request : inFlight) {
+		if (!request.bReplay) {
+			State->Spool.Append(request.Content.GetData(), request.Content.Num(), (uint32)request.Precision);
+		}
+		request.Request->OnProcessRequestComplete().Unbind();
+		request.Request->CancelRequest();
+	}
+
+	if (inFlight.Num() > 0) {
+		UE_LOG(MetricsLog, Log, TEXT("Spooled %d requests still in flight at shutdown."), inFlight.Num());
+	}
+}
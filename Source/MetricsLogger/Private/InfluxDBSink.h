@@ -0,0 +1,117 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+// Parent Class
+#include "IMetricsSink.h"
+#include "MetricsRetryPolicy.h"
+#include "MetricsSpool.h"
+#include "MetricsSettingsSnapshot.h"
+
+typedef TSharedPtr<class IHttpRequest, ESPMode::ThreadSafe> FHttpRequestPtr;
+typedef TSharedPtr<class IHttpResponse, ESPMode::ThreadSafe> FHttpResponsePtr;
+
+/**
+ * Sink that writes batches to InfluxDB.
+ *
+ * Each line protocol batch is submitted in a single HTTP request, with at most InfluxMaxInFlightRequests in flight at
+ * once. While they are all busy batches wait in the sink's queue, so a slow endpoint backs up into the queue's
+ * backpressure policy rather than piling up requests. Batches that can't be delivered are kept in a spool on disk and
+ * replayed in order, one at a time, under FMetricsRetryPolicy once the endpoint is reachable again.
+ */
+class FInfluxDBSink: public IMetricsSink
+{
+public:
+	FInfluxDBSink();
+
+	// Uses the given settings and spool file instead of the project's
+	FInfluxDBSink(const FMetricsSettingsRef& InSettings, const FString& InSpoolFilename);
+	virtual ~FInfluxDBSink();
+
+protected:
+	// IMetricsSink overrides
+	virtual void Write(const FMetricsBatch& Batch) override;
+	virtual bool IsReady() const override;
+	virtual void Update() override;
+
+private:
+	/**
+	 * Everything the HTTP completion callbacks touch. They only hold a weak reference to it, so a request that
+	 * completes after the sink is gone finds nothing left to update.
+	 *
+	 * The callbacks run on the game thread, so all they do is hand the result over - the spool and the retry policy
+	 * are only acted on by the sink thread.
+	 */
+	struct FSendState
+	{
+		FSendState(const FString& SpoolFilename, const FMetricsSettingsSnapshot& Settings);
+
+		// Batches that failed to send (or were still waiting at shutdown), replayed oldest first one at a time
+		FMetricsSpool Spool;
+
+		FCriticalSection Lock;
+
+		// Requests that haven't completed yet, with the uncompressed batch in case it needs to be spooled
+		struct FRequest
+		{
+			FHttpRequestPtr Request;
+			TArray<uint8> Content;
+			TimestampPrecision Precision;
+			bool bReplay;
+			// Which spooled batch a replay is, in case it is evicted while in flight
+			uint64 SpoolSequence;
+			double StartTime;
+		};
+		TArray<FRequest> InFlight;
+		bool bReplayInFlight{ false };
+
+		// Requests that completed and are waiting for the sink thread, along with what the response said
+		struct FCompletion
+		{
+			FRequest Request;
+			EMetricsSendResult Result;
+			int32 ResponseCode;
+			double RetryAfter;
+			FString ResponseContent;
+		};
+		TArray<FCompletion> Completed;
+
+		// Set once the sink has shut down and spooled whatever was still in flight
+		bool bClosed{ false };
+
+		// Backoff and circuit breaker for replays while the endpoint is failing
+		FMetricsRetryPolicy Retry;
+	};
+	typedef TSharedPtr<FSendState, ESPMode::ThreadSafe> FSendStatePtr;
+
+	void ReplaySpool();
+
+	// Spools, pops and updates the retry policy for every request that completed since the last call
+	void ProcessCompletions();
+
+	bool SendLog(TArray<uint8>&& content, TimestampPrecision precision, bool bReplay, uint64 spoolSequence);
+	static void OnLogSendComplete(const FSendStatePtr& State, const FHttpRequestPtr& Request, const FHttpResponsePtr& Response, bool bWasSuccessful);
+
+	// Cancels the requests still in flight and spools their batches to be sent next time
+	void CancelInFlight();
+
+	// Settings for the sink thread, with the write URLs already resolved
+	FMetricsSettingsCache Settings;
+
+	FSendStatePtr State;
+	int32 MaxInFlight;
+};
@@ -0,0 +1,108 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "JsonLinesWriter.h"
+#include "LineProtocolWriter.h"
+
+void FJsonLinesWriter::EncodeTags(const FMetricsTags& Tags, TArray<uint8>& OutEncoded)
+{
+	OutEncoded.Reset();
+
+	for (const TPair<FString, FString>& tag : Tags) {
+		if (OutEncoded.Num() > 0) {
+			OutEncoded.Add(',');
+		}
+
+		FTCHARToUTF8 key(*tag.Key);
+		FTCHARToUTF8 value(*tag.Value);
+		AppendString(OutEncoded, key.Get(), key.Length());
+		OutEncoded.Add(':');
+		AppendString(OutEncoded, value.Get(), value.Length());
+	}
+}
+
+void FJsonLinesWriter::Write(const EventMetaData& data, const TArray<uint8>& EncodedTags, TArray<uint8>& Buffer)
+{
+	const FTCHARToUTF8 measurement(*MetricsLoggerUtils::LogEventTypeToFString(data.type));
+
+	FLineProtocolWriter::AppendLiteral(Buffer, "{\"measurement\":");
+	AppendString(Buffer, measurement.Get(), measurement.Length());
+	FLineProtocolWriter::AppendLiteral(Buffer, ",\"time\":");
+	FLineProtocolWriter::AppendInteger(Buffer, data.startTime);
+
+	FLineProtocolWriter::AppendLiteral(Buffer, ",\"tags\":{");
+	Buffer.Append(EncodedTags);
+	if (EncodedTags.Num() > 0) {
+		Buffer.Add(',');
+	}
+	data.success ? FLineProtocolWriter::AppendLiteral(Buffer, "\"success\":\"True\"") : FLineProtocolWriter::AppendLiteral(Buffer, "\"success\":\"False\"");
+
+	for (int32 i = 0; i < data.numTags; i++) {
+		const EventTag& tag = data.tags[i];
+		Buffer.Add(',');
+		AppendString(Buffer, tag.key, FCStringAnsi::Strlen(tag.key));
+		Buffer.Add(':');
+		AppendString(Buffer, data.tagValues + tag.valueOffset, tag.valueLength);
+	}
+
+	FLineProtocolWriter::AppendLiteral(Buffer, "},\"fields\":{\"event_start\":");
+	FLineProtocolWriter::AppendInteger(Buffer, data.startTime);
+	FLineProtocolWriter::AppendLiteral(Buffer, ",\"event_finish\":");
+	FLineProtocolWriter::AppendInteger(Buffer, data.finishTime);
+	FLineProtocolWriter::AppendLiteral(Buffer, ",\"event_duration\":");
+	FLineProtocolWriter::AppendDouble(Buffer, data.duration);
+
+	if (data.spanId != 0) {
+		FLineProtocolWriter::AppendLiteral(Buffer, ",\"span_id\":");
+		FLineProtocolWriter::AppendInteger(Buffer, data.spanId);
+	}
+	if (data.parentSpanId != 0) {
+		FLineProtocolWriter::AppendLiteral(Buffer, ",\"parent_span_id\":");
+		FLineProtocolWriter::AppendInteger(Buffer, data.parentSpanId);
+	}
+
+	for (int32 i = 0; i < data.numFields; i++) {
+		Buffer.Add(',');
+		AppendString(Buffer, data.fields[i].name, FCStringAnsi::Strlen(data.fields[i].name));
+		Buffer.Add(':');
+		FLineProtocolWriter::AppendDouble(Buffer, data.fields[i].value);
+	}
+
+	FLineProtocolWriter::AppendLiteral(Buffer, "}}\n");
+}
+
+void FJsonLinesWriter::AppendString(TArray<uint8>& Buffer, const ANSICHAR* Chars, int32 Length)
+{
+	static const ANSICHAR* const HexDigits = "0123456789abcdef";
+
+	// Multi-byte UTF-8 sequences pass through unchanged, only quotes, backslashes and control characters are escaped
+	Buffer.Add('"');
+	for (int32 i = 0; i < Length; i++) {
+		const uint8 c = (uint8)Chars[i];
+		if (c == '"' || c == '\\') {
+			Buffer.Add('\\');
+			Buffer.Add(c);
+		}
+		else if (c < 0x20) {
+			FLineProtocolWriter::AppendLiteral(Buffer, "\\u00");
+			Buffer.Add(HexDigits[c >> 4]);
+			Buffer.Add(HexDigits[c & 0xF]);
+		}
+		else {
+			Buffer.Add(c);
+		}
+	}
+	Buffer.Add('"');
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsBatch.h"
+#include "MetricsModel.h"
+
+/**
+ * Serializes events into JSON Lines as UTF-8 bytes - one object per line with the same measurement, tags and fields
+ * as the line protocol, and every timestamp in nanoseconds.
+ *
+ * The metadata tags are the same for every event of a batch, so they are encoded once with EncodeTags and copied into
+ * each line.
+ */
+class FJsonLinesWriter
+{
+public:
+	static void EncodeTags(const FMetricsTags& Tags, TArray<uint8>& OutEncoded);
+
+	// Appends a single event followed by a newline
+	static void Write(const EventMetaData& data, const TArray<uint8>& EncodedTags, TArray<uint8>& Buffer);
+
+private:
+	static void AppendString(TArray<uint8>& Buffer, const ANSICHAR* Chars, int32 Length);
+};
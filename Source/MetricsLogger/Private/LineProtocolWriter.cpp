@@ -0,0 +1,151 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "LineProtocolWriter.h"
+
+// Escapes every character in EscapedChars with a backslash
+static void AppendEscaped(TArray<uint8>& Buffer, const ANSICHAR* Chars, int32 Length, const ANSICHAR* EscapedChars)
+{
+	for (int32 i = 0; i < Length; i++) {
+		if (FCStringAnsi::Strchr(EscapedChars, Chars[i])) {
+			Buffer.Add('\\');
+		}
+		Buffer.Add((uint8)Chars[i]);
+	}
+}
+
+static const ANSICHAR* const MEASUREMENT_ESCAPED_CHARS = ", ";
+static const ANSICHAR* const TAG_ESCAPED_CHARS = ",= ";
+
+void FLineProtocolWriter::Initialize(const TArray<FTag>& Tags, const FString& InUser)
+{
+	User = InUser;
+
+	for (int32 type = 0; type < (int32)LogEventTypeEnum::NUM; type++) {
+		for (int32 success = 0; success < 2; success++) {
+			TArray<uint8>& prefix = Prefixes[type][success];
+			prefix.Reset();
+
+			AppendMeasurement(prefix, MetricsLoggerUtils::LogEventTypeToFString((LogEventTypeEnum)type));
+
+			for (const FTag& tag : Tags) {
+				prefix.Add(',');
+				AppendTag(prefix, tag.Key);
+				prefix.Add('=');
+				// Empty tag values aren't valid line protocol
+				AppendTag(prefix, tag.Value.IsEmpty() ? TEXT("N/A") : tag.Value);
+			}
+
+			success ? AppendLiteral(prefix, ",success=True,user=") : AppendLiteral(prefix, ",success=False,user=");
+			AppendTag(prefix, User.IsEmpty() ? TEXT("N/A") : User);
+		}
+	}
+
+	bInitialized = true;
+}
+
+void FLineProtocolWriter::Write(const EventMetaData& data, int64 TimestampUnit, TArray<uint8>& Buffer) const
+{
+	// Format specified here: https://docs.influxdata.com/influxdb/v1.8/write_protocols/line_protocol_tutorial/
+	Buffer.Append(Prefixes[(int32)data.type][data.success ? 1 : 0]);
+
+	for (int32 i = 0; i < data.numTags; i++) {
+		const EventTag& tag = data.tags[i];
+		Buffer.Add(',');
+		Buffer.Append((const uint8*)tag.key, FCStringAnsi::Strlen(tag.key));
+		Buffer.Add('=');
+		if (tag.valueLength > 0) {
+			AppendEscaped(Buffer, data.tagValues + tag.valueOffset, tag.valueLength, TAG_ESCAPED_CHARS);
+		}
+		else {
+			AppendLiteral(Buffer, "N/A");
+		}
+	}
+
+	AppendLiteral(Buffer, " event_start=");
+	AppendInteger(Buffer, data.startTime / TimestampUnit);
+	AppendLiteral(Buffer, ",event_finish=");
+	AppendInteger(Buffer, data.finishTime / TimestampUnit);
+	AppendLiteral(Buffer, ",event_duration=");
+	AppendDouble(Buffer, data.duration);
+
+	// Ids are integer fields so they keep all 64 bits
+	if (data.spanId != 0) {
+		AppendLiteral(Buffer, ",span_id=");
+		AppendInteger(Buffer, data.spanId);
+		Buffer.Add('i');
+	}
+	if (data.parentSpanId != 0) {
+		AppendLiteral(Buffer, ",parent_span_id=");
+		AppendInteger(Buffer, data.parentSpanId);
+		Buffer.Add('i');
+	}
+
+	for (int32 i = 0; i < data.numFields; i++) {
+		Buffer.Add(',');
+		Buffer.Append((const uint8*)data.fields[i].name, FCStringAnsi::Strlen(data.fields[i].name));
+		Buffer.Add('=');
+		AppendDouble(Buffer, data.fields[i].value);
+	}
+
+	Buffer.Add(' ');
+	AppendInteger(Buffer, data.startTime / TimestampUnit);
+	Buffer.Add('\n');
+}
+
+void FLineProtocolWriter::AppendMeasurement(TArray<uint8>& Buffer, const FString& Value)
+{
+	FTCHARToUTF8 utf8(*Value);
+	AppendEscaped(Buffer, utf8.Get(), utf8.Length(), MEASUREMENT_ESCAPED_CHARS);
+}
+
+void FLineProtocolWriter::AppendTag(TArray<uint8>& Buffer, const FString& Value)
+{
+	FTCHARToUTF8 utf8(*Value);
+	AppendEscaped(Buffer, utf8.Get(), utf8.Length(), TAG_ESCAPED_CHARS);
+}
+
+void FLineProtocolWriter::AppendInteger(TArray<uint8>& Buffer, int64 Value)
+{
+	// Digits are produced backwards into a scratch buffer - 20 characters covers any int64
+	ANSICHAR digits[20];
+	int32 numDigits = 0;
+
+	uint64 magnitude = Value < 0 ? 0 - (uint64)Value : (uint64)Value;
+	do {
+		digits[numDigits++] = '0' + (ANSICHAR)(magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude > 0);
+
+	if (Value < 0) {
+		Buffer.Add('-');
+	}
+	while (numDigits > 0) {
+		Buffer.Add((uint8)digits[--numDigits]);
+	}
+}
+
+void FLineProtocolWriter::AppendDouble(TArray<uint8>& Buffer, double Value)
+{
+	// Line protocol has no representation for these
+	if (!FMath::IsFinite(Value)) {
+		Value = 0.0;
+	}
+
+	// Exponents are fine for line protocol, JSON and StatsD alike
+	ANSICHAR digits[32];
+	const int32 length = FCStringAnsi::Snprintf(digits, sizeof(digits), "%.15g", Value);
+	Buffer.Append((const uint8*)digits, FMath::Clamp(length, 0, (int32)sizeof(digits) - 1));
+}
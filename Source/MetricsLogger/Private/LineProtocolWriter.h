@@ -0,0 +1,62 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsModel.h"
+
+/**
+ * Serializes events into InfluxDB line protocol as UTF-8 bytes.
+ *
+ * Everything that is the same for every point of an event type - the measurement, the machine metadata tags and the
+ * success/user tags - is escaped and encoded once up front. Writing a point only copies that prefix and formats the
+ * numeric fields straight into the caller's buffer, so nothing is allocated once the buffer has grown to size.
+ */
+class FLineProtocolWriter
+{
+public:
+	typedef TPair<FString, FString> FTag;
+
+	// Encodes the prefix of every event type from the machine metadata tags and the user tag value
+	void Initialize(const TArray<FTag>& Tags, const FString& InUser);
+
+	// Appends a single point followed by a newline, with timestamps in units of TimestampUnit nanoseconds
+	void Write(const EventMetaData& data, int64 TimestampUnit, TArray<uint8>& Buffer) const;
+
+	bool IsInitialized() const { return bInitialized; }
+	const FString& GetUser() const { return User; }
+
+	// Escaping rules from https://docs.influxdata.com/influxdb/v1.8/write_protocols/line_protocol_reference/#special-characters
+	static void AppendMeasurement(TArray<uint8>& Buffer, const FString& Value);
+	static void AppendTag(TArray<uint8>& Buffer, const FString& Value);
+
+	static void AppendInteger(TArray<uint8>& Buffer, int64 Value);
+	// Writes Value with up to 15 significant digits, so short durations and large counts both keep their precision
+	static void AppendDouble(TArray<uint8>& Buffer, double Value);
+
+	template<int32 N>
+	static void AppendLiteral(TArray<uint8>& Buffer, const ANSICHAR(&Literal)[N])
+	{
+		Buffer.Append((const uint8*)Literal, N - 1);
+	}
+
+private:
+	// Encoded "<measurement>,<tags>,success=<True|False>,user=<user>" per event type and success value
+	TArray<uint8> Prefixes[(int32)LogEventTypeEnum::NUM][2];
+
+	FString User;
+	bool bInitialized{ false };
+};
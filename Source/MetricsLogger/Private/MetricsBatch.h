@@ -0,0 +1,41 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsModel.h"
+#include "MetricsLoggerSettings.h"
+
+// Metadata tags shared by every event in a batch, ending with the user tag
+typedef TArray<TPair<FString, FString>> FMetricsTags;
+
+/**
+ * A batch of events serialized once by the logger pipeline and shared read-only between every sink.
+ */
+struct FMetricsBatch
+{
+	// Events in the batch, for sinks that write their own format
+	TArray<EventMetaData> Events;
+
+	// UTF-8 line protocol of every event, with timestamps in units of Precision
+	TArray<uint8> LineProtocol;
+	TimestampPrecision Precision{ TimestampPrecision::Seconds };
+
+	// Metadata tags for sinks that write their own format - shared with every other batch until the metadata changes
+	TSharedPtr<const FMetricsTags, ESPMode::ThreadSafe> Tags;
+};
+
+typedef TSharedRef<const FMetricsBatch, ESPMode::ThreadSafe> FMetricsBatchRef;
@@ -0,0 +1,34 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsBenchmarkCommandlet.h"
+#include "MetricsLogCategory.h"
+#include "MetricsLoggerBenchmark.h"
+
+UMetricsBenchmarkCommandlet::UMetricsBenchmarkCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	LogToConsole = true;
+}
+
+int32 UMetricsBenchmarkCommandlet::Main(const FString& Params)
+{
+#if !UE_BUILD_SHIPPING
+	return MetricsLoggerBenchmark::RunPipeline(*Params) ? 0 : 1;
+#else
+	UE_LOG(MetricsLog, Error, TEXT("Benchmarks aren't available in shipping builds."));
+	return 1;
+#endif
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "MetricsBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs the logger's event to wire benchmark headless and fails if it misses any of the thresholds given, so a build
+ * machine can catch performance regressions in the logger.
+ *
+ * Usage: -run=MetricsBenchmark [-Events=N] [-MinEventsPerSec=N] [-MaxP99Us=N] [-MaxAllocsPerEvent=N] [-MaxBytesPerPoint=N]
+ */
+UCLASS()
+class UMetricsBenchmarkCommandlet: public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UMetricsBenchmarkCommandlet(const FObjectInitializer& ObjectInitializer);
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,358 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsBinaryFormat.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Crc.h"
+#include "MetricsLogCategory.h"
+
+// Header written in front of every block
+struct FBinaryBlockHeader
+{
+	uint32 Size;
+	uint32 Crc;
+	uint32 NumEvents;
+};
+
+static void WriteVarint(TArray<uint8>& Buffer, uint64 Value)
+{
+	while (Value >= 0x80) {
+		Buffer.Add((uint8)(Value | 0x80));
+		Value >>= 7;
+	}
+	Buffer.Add((uint8)Value);
+}
+
+// Zigzag encoding keeps small negative deltas small
+static void WriteSignedVarint(TArray<uint8>& Buffer, int64 Value)
+{
+	WriteVarint(Buffer, ((uint64)Value << 1) ^ (uint64)(Value >> 63));
+}
+
+static void WriteDouble(TArray<uint8>& Buffer, double Value)
+{
+	Buffer.Append((const uint8*)&Value, sizeof(Value));
+}
+
+/**
+ * Bounds checked cursor over a block payload - any read past the end marks it as failed and returns zero.
+ */
+struct FBinaryCursor
+{
+	const uint8* Data;
+	int32 Size;
+	int32 Offset{ 0 };
+	bool bFailed{ false };
+
+	FBinaryCursor(const TArray<uint8>& Payload) : Data(Payload.GetData()), Size(Payload.Num()) {}
+
+	uint64 ReadVarint()
+	{
+		uint64 value = 0;
+		for (int32 shift = 0; shift < 64; shift += 7) {
+			if (Offset >= Size) break;
+
+			const uint8 byte = Data[Offset++];
+			value |= (uint64)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) return value;
+		}
+		bFailed = true;
+		return 0;
+	}
+
+	int64 ReadSignedVarint()
+	{
+		const uint64 value = ReadVarint();
+		return (int64)(value >> 1) ^ -(int64)(value & 1);
+	}
+
+	uint8 ReadByte()
+	{
+		if (Offset >= Size) {
+			bFailed = true;
+			return 0;
+		}
+		return Data[Offset++];
+	}
+
+	double ReadDouble()
+	{
+		double value = 0.0;
+		if (Offset + (int32)sizeof(value) > Size) {
+			bFailed = true;
+			return value;
+		}
+		FMemory::Memcpy(&value, Data + Offset, sizeof(value));
+		Offset += sizeof(value);
+		return value;
+	}
+
+	const uint8* ReadBytes(int32 Length)
+	{
+		if (Length < 0 || Offset + Length > Size) {
+			bFailed = true;
+			return nullptr;
+		}
+		const uint8* bytes = Data + Offset;
+		Offset += Length;
+		return bytes;
+	}
+};
+
+void MetricsBinaryFormat::WriteFileHeader(TArray<uint8>& Buffer)
+{
+	const uint32 header[] = { FILE_MAGIC, FILE_VERSION };
+	Buffer.Append((const uint8*)header, sizeof(header));
+}
+
+void FMetricsBinaryWriter::Reset()
+{
+	Dictionary.Reset();
+	LiteralIds.Reset();
+}
+
+void FMetricsBinaryWriter::WriteBlock(const FMetricsBatch& Batch, TArray<uint8>& Buffer)
+{
+	NewStrings.Reset();
+	NumNewStrings = 0;
+	Columns.Reset();
+
+	// Metadata tags
+	const int32 numMetaTags = Batch.Tags.IsValid() ? Batch.Tags->Num() : 0;
+	WriteVarint(Columns, numMetaTags);
+	for (int32 i = 0; i < numMetaTags; i++) {
+		WriteVarint(Columns, Intern((*Batch.Tags)[i].Key));
+		WriteVarint(Columns, Intern((*Batch.Tags)[i].Value));
+	}
+
+	// Event columns
+	for (const EventMetaData& data : Batch.Events) {
+		Columns.Add((uint8)data.type);
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		Columns.Add(data.success ? 1 : 0);
+	}
+	int64 previousStart = 0;
+	for (const EventMetaData& data : Batch.Events) {
+		WriteSignedVarint(Columns, data.startTime - previousStart);
+		previousStart = data.startTime;
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		WriteSignedVarint(Columns, data.finishTime - data.startTime);
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		WriteDouble(Columns, data.duration);
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		WriteVarint(Columns, data.spanId);
+		WriteVarint(Columns, data.parentSpanId);
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		Columns.Add((uint8)data.numTags);
+		for (int32 i = 0; i < data.numTags; i++) {
+			const EventTag& tag = data.tags[i];
+			WriteVarint(Columns, InternLiteral(tag.key));
+			WriteVarint(Columns, Intern(data.tagValues + tag.valueOffset, tag.valueLength));
+		}
+	}
+	for (const EventMetaData& data : Batch.Events) {
+		Columns.Add((uint8)data.numFields);
+		for (int32 i = 0; i < data.numFields; i++) {
+			WriteVarint(Columns, InternLiteral(data.fields[i].name));
+			WriteDouble(Columns, data.fields[i].value);
+		}
+	}
+
+	// The strings have to come first so the reader knows them before it meets their ids
+	const int32 headerOffset = Buffer.Num();
+	Buffer.AddUninitialized(sizeof(FBinaryBlockHeader));
+
+	const int32 payloadOffset = Buffer.Num();
+	WriteVarint(Buffer, NumNewStrings);
+	Buffer.Append(NewStrings);
+	Buffer.Append(Columns);
+
+	FBinaryBlockHeader header;
+	header.Size = Buffer.Num() - payloadOffset;
+	header.Crc = FCrc::MemCrc32(Buffer.GetData() + payloadOffset, header.Size);
+	header.NumEvents = Batch.Events.Num();
+	FMemory::Memcpy(Buffer.GetData() + headerOffset, &header, sizeof(header));
+}
+
+uint32 FMetricsBinaryWriter::Intern(const FString& Value)
+{
+	if (const uint32* id = Dictionary.Find(Value)) return *id;
+
+	const uint32 id = Dictionary.Num();
+	Dictionary.Add(Value, id);
+
+	FTCHARToUTF8 utf8(*Value);
+	WriteVarint(NewStrings, utf8.Length());
+	NewStrings.Append((const uint8*)utf8.Get(), utf8.Length());
+	NumNewStrings++;
+
+	return id;
+}
+
+uint32 FMetricsBinaryWriter::Intern(const ANSICHAR* Utf8, int32 Length)
+{
+	FUTF8ToTCHAR value(Utf8, Length);
+	return Intern(FString(value.Length(), value.Get()));
+}
+
+uint32 FMetricsBinaryWriter::InternLiteral(const ANSICHAR* Literal)
+{
+	// Keys and names are string literals, so the same pointer comes around again and again
+	if (const uint32* id = LiteralIds.Find(Literal)) return *id;
+
+	const uint32 id = Intern(Literal, FCStringAnsi::Strlen(Literal));
+	LiteralIds.Add(Literal, id);
+	return id;
+}
+
+FMetricsBinaryReader::FMetricsBinaryReader()
+{
+}
+
+FMetricsBinaryReader::~FMetricsBinaryReader()
+{
+}
+
+bool FMetricsBinaryReader::Open(const FString& InFilename)
+{
+	Filename = InFilename;
+	Strings.Reset();
+	bDamaged = false;
+
+	Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!Handle) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not open %s."), *Filename);
+		return false;
+	}
+
+	uint32 header[2];
+	if (!Handle->Read((uint8*)header, sizeof(header)) || header[0] != MetricsBinaryFormat::FILE_MAGIC) {
+		UE_LOG(MetricsLog, Error, TEXT("%s is not a metrics file."), *Filename);
+		return false;
+	}
+	if (header[1] > MetricsBinaryFormat::FILE_VERSION) {
+		UE_LOG(MetricsLog, Error, TEXT("%s was written with format version %u, which is newer than this one."), *Filename, header[1]);
+		return false;
+	}
+	return true;
+}
+
+bool FMetricsBinaryReader::ReadBlock(TArray<EventMetaData>& OutEvents, FMetricsTags& OutTags)
+{
+	if (!Handle || bDamaged) return false;
+
+	FBinaryBlockHeader header;
+	const int64 remaining = Handle->Size() - Handle->Tell();
+	if (remaining == 0) return false;
+
+	if (remaining < (int64)sizeof(header) || !Handle->Read((uint8*)&header, sizeof(header)) || (int64)header.Size > remaining - (int64)sizeof(header)) {
+		UE_LOG(MetricsLog, Warning, TEXT("%s ends with an incomplete block."), *Filename);
+		bDamaged = true;
+		return false;
+	}
+
+	Payload.SetNumUninitialized(header.Size, false);
+	if (!Handle->Read(Payload.GetData(), header.Size) || FCrc::MemCrc32(Payload.GetData(), header.Size) != header.Crc) {
+		UE_LOG(MetricsLog, Warning, TEXT("%s has a damaged block."), *Filename);
+		bDamaged = true;
+		return false;
+	}
+
+	FBinaryCursor cursor(Payload);
+	const int32 numStrings = Strings.Num();
+	auto GetString = [this, &cursor]() -> const ANSICHAR* {
+		const uint64 id = cursor.ReadVarint();
+		if (id >= (uint64)Strings.Num()) {
+			cursor.bFailed = true;
+			return "";
+		}
+		return Strings[id].GetData();
+	};
+
+	// Dictionary
+	const uint64 numNewStrings = cursor.ReadVarint();
+	for (uint64 i = 0; i < numNewStrings && !cursor.bFailed; i++) {
+		const int32 length = (int32)cursor.ReadVarint();
+		if (const uint8* bytes = cursor.ReadBytes(length)) {
+			TArray<ANSICHAR>& entry = Strings.AddDefaulted_GetRef();
+			entry.Append((const ANSICHAR*)bytes, length);
+			entry.Add('\0');
+		}
+	}
+
+	// Metadata tags
+	OutTags.Reset();
+	const uint64 numMetaTags = cursor.ReadVarint();
+	for (uint64 i = 0; i < numMetaTags && !cursor.bFailed; i++) {
+		const ANSICHAR* key = GetString();
+		const ANSICHAR* value = GetString();
+		OutTags.Emplace(UTF8_TO_TCHAR(key), UTF8_TO_TCHAR(value));
+	}
+
+	// Event columns
+	OutEvents.Reset();
+	OutEvents.SetNum(header.NumEvents);
+
+	for (EventMetaData& data : OutEvents) {
+		const uint8 type = cursor.ReadByte();
+		data.type = type < (uint8)LogEventTypeEnum::NUM ? (LogEventTypeEnum)type : LogEventTypeEnum::UKNOWN;
+	}
+	for (EventMetaData& data : OutEvents) {
+		data.success = cursor.ReadByte() != 0;
+	}
+	int64 previousStart = 0;
+	for (EventMetaData& data : OutEvents) {
+		data.startTime = previousStart + cursor.ReadSignedVarint();
+		previousStart = data.startTime;
+	}
+	for (EventMetaData& data : OutEvents) {
+		data.finishTime = data.startTime + cursor.ReadSignedVarint();
+	}
+	for (EventMetaData& data : OutEvents) {
+		data.duration = cursor.ReadDouble();
+	}
+	for (EventMetaData& data : OutEvents) {
+		data.spanId = cursor.ReadVarint();
+		data.parentSpanId = cursor.ReadVarint();
+	}
+	for (EventMetaData& data : OutEvents) {
+		const uint8 numTags = cursor.ReadByte();
+		for (uint8 i = 0; i < numTags && !cursor.bFailed; i++) {
+			const ANSICHAR* key = GetString();
+			const ANSICHAR* value = GetString();
+			data.AddTagUtf8(key, value, FCStringAnsi::Strlen(value));
+		}
+	}
+	for (EventMetaData& data : OutEvents) {
+		const uint8 numFields = cursor.ReadByte();
+		for (uint8 i = 0; i < numFields && !cursor.bFailed; i++) {
+			const ANSICHAR* name = GetString();
+			data.AddField(name, cursor.ReadDouble());
+		}
+	}
+
+	if (cursor.bFailed) {
+		UE_LOG(MetricsLog, Warning, TEXT("%s has a block that could not be decoded."), *Filename);
+		Strings.SetNum(numStrings);
+		bDamaged = true;
+		return false;
+	}
+	return true;
+}
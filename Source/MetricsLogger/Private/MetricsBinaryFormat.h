@@ -0,0 +1,104 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsBatch.h"
+#include "MetricsModel.h"
+
+class IFileHandle;
+
+/**
+ * Compact binary file format for events.
+ *
+ * A file starts with a magic number and format version, followed by one block per batch. Each block has a header with
+ * its size, checksum and event count so a torn block at the end of a file is detected and skipped. Inside a block:
+ *
+ *  - the strings first used by the block, appended to a dictionary that lives for the whole file
+ *  - the metadata tags of the batch as dictionary ids
+ *  - the events stored column by column - types, success flags, start times as zigzag varint deltas from the previous
+ *    event, finish times as deltas from the start, durations, span ids, tags as dictionary ids and fields
+ *
+ * Timestamps are always stored in nanoseconds. Blocks can be decoded one at a time, so a file of any size is read with
+ * memory bounded by its largest block and its dictionary.
+ */
+namespace MetricsBinaryFormat
+{
+	const uint32 FILE_MAGIC = 0x424D4555; // "UEMB"
+	const uint32 FILE_VERSION = 1;
+
+	// Appends the header every file starts with
+	void WriteFileHeader(TArray<uint8>& Buffer);
+}
+
+/**
+ * Encodes batches into blocks of the binary format. The dictionary is per file, so Reset must be called whenever a new
+ * file is started.
+ */
+class FMetricsBinaryWriter
+{
+public:
+	void Reset();
+
+	// Appends a block holding every event of the batch
+	void WriteBlock(const FMetricsBatch& Batch, TArray<uint8>& Buffer);
+
+private:
+	uint32 Intern(const FString& Value);
+	uint32 Intern(const ANSICHAR* Utf8, int32 Length);
+	uint32 InternLiteral(const ANSICHAR* Literal);
+
+	// Ids of every string written to the file so far
+	TMap<FString, uint32> Dictionary;
+	TMap<const ANSICHAR*, uint32> LiteralIds;
+
+	// Strings added to the dictionary by the block being written
+	TArray<uint8> NewStrings;
+	uint32 NumNewStrings{ 0 };
+
+	// Scratch buffer for the event columns
+	TArray<uint8> Columns;
+};
+
+/**
+ * Decodes a file of the binary format one block at a time.
+ */
+class FMetricsBinaryReader
+{
+public:
+	FMetricsBinaryReader();
+	~FMetricsBinaryReader();
+
+	bool Open(const FString& Filename);
+
+	// Reads the next block. Returns false at the end of the file or at a damaged block - IsDamaged tells them apart.
+	// The tag keys and field names of the events point into the reader's dictionary, so they stay valid as long as it.
+	bool ReadBlock(TArray<EventMetaData>& OutEvents, FMetricsTags& OutTags);
+
+	// Whether reading stopped at a damaged or truncated block rather than the end of the file
+	bool IsDamaged() const { return bDamaged; }
+
+private:
+	TUniquePtr<IFileHandle> Handle;
+	FString Filename;
+	bool bDamaged{ false };
+
+	// Null terminated UTF-8 strings by id
+	TArray<TArray<ANSICHAR>> Strings;
+
+	// Payload of the block being decoded
+	TArray<uint8> Payload;
+};
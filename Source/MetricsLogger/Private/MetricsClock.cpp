@@ -0,0 +1,39 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsClock.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+
+// UTC time and cycle counter captured together the first time the clock is used
+struct FMetricsClockAnchor
+{
+	FMetricsClockAnchor()
+		: Cycles(FPlatformTime::Cycles64())
+		, UnixNanoseconds((FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() * 100)
+	{
+	}
+
+	uint64 Cycles;
+	int64 UnixNanoseconds;
+};
+
+int64 FMetricsClock::Now()
+{
+	static const FMetricsClockAnchor Anchor;
+
+	const double elapsed = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Anchor.Cycles);
+	return Anchor.UnixNanoseconds + FromSeconds(elapsed);
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+/**
+ * High resolution wall clock for event timestamps.
+ *
+ * FDateTime::UtcNow is only accurate to around a millisecond on some platforms and can jump when the system clock is
+ * adjusted. Instead the UTC time is read once and every timestamp after that is derived from the monotonic cycle
+ * counter, so timestamps are consistent with each other to the resolution of FPlatformTime::Cycles64.
+ */
+struct FMetricsClock
+{
+	// Current UTC time in nanoseconds since the Unix epoch
+	static int64 Now();
+
+	static double ToSeconds(int64 nanoseconds)
+	{
+		return nanoseconds * 1e-9;
+	}
+
+	static int64 FromSeconds(double seconds)
+	{
+		return (int64)(seconds * 1e9);
+	}
+};
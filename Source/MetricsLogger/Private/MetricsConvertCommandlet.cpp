@@ -0,0 +1,225 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsConvertCommandlet.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "LineProtocolWriter.h"
+#include "MetricsBinaryFormat.h"
+#include "MetricsLogCategory.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+// Converted output is written out whenever this much has built up
+const int32 OUTPUT_CHUNK_BYTES = 4 * 1024 * 1024;
+
+// Nanoseconds per unit of a precision given on the command line
+static int64 ParseTimestampUnit(const FString& precision)
+{
+	if (precision == TEXT("ms")) return 1000000;
+	if (precision == TEXT("us")) return 1000;
+	if (precision == TEXT("ns")) return 1;
+	return 1000000000;
+}
+
+// Quotes a CSV value if it needs it
+static void AppendCsvValue(TArray<uint8>& Buffer, const ANSICHAR* Chars, int32 Length)
+{
+	bool bQuote = false;
+	for (int32 i = 0; i < Length && !bQuote; i++) {
+		bQuote = Chars[i] == ',' || Chars[i] == '"' || Chars[i] == '\n' || Chars[i] == '\r';
+	}
+
+	if (bQuote) {
+		Buffer.Add('"');
+	}
+	for (int32 i = 0; i < Length; i++) {
+		if (Chars[i] == '"') {
+			Buffer.Add('"');
+		}
+		Buffer.Add((uint8)Chars[i]);
+	}
+	if (bQuote) {
+		Buffer.Add('"');
+	}
+}
+
+// Appends an event as a CSV row, with the tags and the fields each as "key=value;key=value" in a single value
+static void AppendCsvEvent(TArray<uint8>& Buffer, const EventMetaData& data, const TArray<uint8>& EncodedTags)
+{
+	FLineProtocolWriter::AppendMeasurement(Buffer, MetricsLoggerUtils::LogEventTypeToFString(data.type));
+	Buffer.Add(',');
+	FLineProtocolWriter::AppendInteger(Buffer, data.startTime);
+	Buffer.Add(',');
+	data.success ? FLineProtocolWriter::AppendLiteral(Buffer, "True,") : FLineProtocolWriter::AppendLiteral(Buffer, "False,");
+	FLineProtocolWriter::AppendInteger(Buffer, data.finishTime);
+	Buffer.Add(',');
+	FLineProtocolWriter::AppendDouble(Buffer, data.duration);
+	Buffer.Add(',');
+	FLineProtocolWriter::AppendInteger(Buffer, data.spanId);
+	Buffer.Add(',');
+	FLineProtocolWriter::AppendInteger(Buffer, data.parentSpanId);
+	Buffer.Add(',');
+
+	TArray<uint8> value(EncodedTags);
+	for (int32 i = 0; i < data.numTags; i++) {
+		const EventTag& tag = data.tags[i];
+		if (value.Num() > 0) {
+			value.Add(';');
+		}
+		value.Append((const uint8*)tag.key, FCStringAnsi::Strlen(tag.key));
+		value.Add('=');
+		value.Append((const uint8*)data.tagValues + tag.valueOffset, tag.valueLength);
+	}
+	AppendCsvValue(Buffer, (const ANSICHAR*)value.GetData(), value.Num());
+	Buffer.Add(',');
+
+	value.Reset();
+	for (int32 i = 0; i < data.numFields; i++) {
+		if (i > 0) {
+			value.Add(';');
+		}
+		value.Append((const uint8*)data.fields[i].name, FCStringAnsi::Strlen(data.fields[i].name));
+		value.Add('=');
+		FLineProtocolWriter::AppendDouble(value, data.fields[i].value);
+	}
+	AppendCsvValue(Buffer, (const ANSICHAR*)value.GetData(), value.Num());
+	Buffer.Add('\n');
+}
+
+UMetricsConvertCommandlet::UMetricsConvertCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	LogToConsole = true;
+}
+
+int32 UMetricsConvertCommandlet::Main(const FString& Params)
+{
+	FString input;
+	FString output;
+	FString format = TEXT("lp");
+	FString precision = TEXT("ns");
+	FParse::Value(*Params, TEXT("Input="), input);
+	FParse::Value(*Params, TEXT("Output="), output);
+	FParse::Value(*Params, TEXT("Format="), format);
+	FParse::Value(*Params, TEXT("Precision="), precision);
+
+	if (input.IsEmpty() || output.IsEmpty()) {
+		UE_LOG(MetricsLog, Error, TEXT("Usage: -run=MetricsConvert -Input=<file or directory> -Output=<file> [-Format=lp|csv] [-Precision=s|ms|us|ns]"));
+		return 1;
+	}
+
+	const bool bCsv = format == TEXT("csv");
+	const int64 timestampUnit = ParseTimestampUnit(precision);
+
+	// A directory converts every completed binary file in it, oldest first by name
+	TArray<FString> inputFiles;
+	if (FPaths::DirectoryExists(input)) {
+		IFileManager::Get().FindFiles(inputFiles, *(input / TEXT("*.mbin")), true, false);
+		inputFiles.Sort();
+		for (FString& file : inputFiles) {
+			file = input / file;
+		}
+	}
+	else {
+		inputFiles.Add(input);
+	}
+
+	TUniquePtr<IFileHandle> outputHandle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*output));
+	if (!outputHandle) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not open %s for writing."), *output);
+		return 1;
+	}
+
+	TArray<uint8> buffer;
+	buffer.Reserve(OUTPUT_CHUNK_BYTES * 2);
+	if (bCsv) {
+		FLineProtocolWriter::AppendLiteral(buffer, "measurement,time,success,event_finish,event_duration,span_id,parent_span_id,tags,fields\n");
+	}
+
+	FLineProtocolWriter writer;
+	FMetricsTags writerTags;
+	TArray<uint8> encodedTags;
+	TArray<EventMetaData> events;
+	FMetricsTags tags;
+	int64 totalEvents = 0;
+	bool bSuccess = true;
+
+	for (const FString& file : inputFiles) {
+		FMetricsBinaryReader reader;
+		if (!reader.Open(file)) {
+			bSuccess = false;
+			continue;
+		}
+
+		int64 fileEvents = 0;
+		while (reader.ReadBlock(events, tags)) {
+			// Metadata only changes between blocks, so it is encoded once per change
+			if (tags != writerTags) {
+				writerTags = tags;
+
+				FMetricsTags machineTags = tags;
+				FString user;
+				if (machineTags.Num() > 0 && machineTags.Last().Key == TEXT("user")) {
+					user = machineTags.Pop().Value;
+				}
+				writer.Initialize(machineTags, user);
+
+				encodedTags.Reset();
+				for (const TPair<FString, FString>& tag : tags) {
+					if (encodedTags.Num() > 0) {
+						encodedTags.Add(';');
+					}
+					FTCHARToUTF8 key(*tag.Key);
+					FTCHARToUTF8 value(*tag.Value);
+					encodedTags.Append((const uint8*)key.Get(), key.Length());
+					encodedTags.Add('=');
+					encodedTags.Append((const uint8*)value.Get(), value.Length());
+				}
+			}
+
+			for (const EventMetaData& data : events) {
+				if (bCsv) {
+					AppendCsvEvent(buffer, data, encodedTags);
+				}
+				else {
+					writer.Write(data, timestampUnit, buffer);
+				}
+			}
+			fileEvents += events.Num();
+
+			if (buffer.Num() >= OUTPUT_CHUNK_BYTES) {
+				outputHandle->Write(buffer.GetData(), buffer.Num());
+				buffer.Reset();
+			}
+		}
+
+		UE_LOG(MetricsLog, Display, TEXT("Converted %lld events from %s."), fileEvents, *file);
+		totalEvents += fileEvents;
+
+		// Everything after a damaged block is lost, which has to fail the conversion rather than look like a short file
+		if (reader.IsDamaged()) {
+			UE_LOG(MetricsLog, Error, TEXT("%s is damaged - events after the first damaged block were not converted."), *file);
+			bSuccess = false;
+		}
+	}
+
+	if (buffer.Num() > 0) {
+		outputHandle->Write(buffer.GetData(), buffer.Num());
+	}
+
+	UE_LOG(MetricsLog, Display, TEXT("Wrote %lld events from %d files to %s."), totalEvents, inputFiles.Num(), *output);
+	return bSuccess ? 0 : 1;
+}
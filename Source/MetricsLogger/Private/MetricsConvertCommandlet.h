@@ -0,0 +1,38 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "MetricsConvertCommandlet.generated.h"
+
+/**
+ * Converts binary metrics files written by the file sink into line protocol or CSV.
+ *
+ * Files are streamed a block at a time and the output is written in chunks, so archives of any size convert with
+ * bounded memory. The line protocol output can be imported into InfluxDB in bulk with its own tools.
+ *
+ * Usage: -run=MetricsConvert -Input=<file or directory> -Output=<file> [-Format=lp|csv] [-Precision=s|ms|us|ns]
+ */
+UCLASS()
+class UMetricsConvertCommandlet: public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UMetricsConvertCommandlet(const FObjectInitializer& ObjectInitializer);
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,124 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsCustomAggregator.h"
+#include "MetricsClock.h"
+
+static const TCHAR* GetKindName(EMetricKind Kind)
+{
+	switch (Kind)
+	{
+		case EMetricKind::Counter:
+			return TEXT("counter");
+		case EMetricKind::Gauge:
+			return TEXT("gauge");
+		default:
+			return TEXT("timer");
+	}
+}
+
+FMetricsCustomAggregator::FMetricsCustomAggregator()
+	: IntervalStart(FMetricsClock::Now())
+{
+}
+
+void FMetricsCustomAggregator::Merge(uint32 MetricId, const FMetricsThreadValue& Value)
+{
+	FAggregate& aggregate = FindOrAddAggregate(MetricId);
+
+	switch (aggregate.Kind)
+	{
+		case EMetricKind::Timer:
+			aggregate.Durations.Merge(Value.Durations);
+			break;
+		case EMetricKind::Counter:
+			aggregate.Value += Value.Value;
+			break;
+		case EMetricKind::Gauge:
+			// Threads are drained in no particular order
+			if (Value.SetCycles >= aggregate.SetCycles) {
+				aggregate.Value = Value.Value;
+				aggregate.SetCycles = Value.SetCycles;
+			}
+			break;
+	}
+	aggregate.bUpdated = true;
+}
+
+FMetricsCustomAggregator::FAggregate& FMetricsCustomAggregator::FindOrAddAggregate(uint32 MetricId)
+{
+	if (FAggregate* aggregate = Aggregates.Find(MetricId)) {
+		return *aggregate;
+	}
+
+	FName name;
+	EMetricKind kind = EMetricKind::Timer;
+	FMetricsRecorderRegistry::GetMetric(MetricId, name, kind);
+
+	FAggregate& aggregate = Aggregates.Add(MetricId);
+	aggregate.Name = name.ToString();
+	aggregate.Kind = kind;
+	return aggregate;
+}
+
+void FMetricsCustomAggregator::Summarize(int64 Now, TArray<EventMetaData>& OutPoints)
+{
+	const int64 intervalStart = IntervalStart;
+	IntervalStart = Now;
+
+	for (auto it = Aggregates.CreateIterator(); it; ++it) {
+		FAggregate& aggregate = it.Value();
+		if (!aggregate.bUpdated) {
+			// Nothing can be recorded for it any more once every site is gone
+			FName name;
+			EMetricKind kind;
+			if (!FMetricsRecorderRegistry::GetMetric(it.Key(), name, kind)) {
+				it.RemoveCurrent();
+			}
+			continue;
+		}
+
+		EventMetaData& point = OutPoints.AddDefaulted_GetRef();
+		point.type = LogEventTypeEnum::CUSTOM;
+		point.startTime = intervalStart;
+		point.finishTime = Now;
+		point.duration = FMetricsClock::ToSeconds(Now - intervalStart);
+		point.success = true;
+		point.AddTag("metric", *aggregate.Name);
+		point.AddTag("kind", GetKindName(aggregate.Kind));
+
+		if (aggregate.Kind == EMetricKind::Timer) {
+			const FMetricsHistogram& durations = aggregate.Durations;
+			point.AddField("count", durations.GetCount());
+			point.AddField("duration_total", durations.GetMean() * durations.GetCount());
+			point.AddField("duration_min", durations.GetMin());
+			point.AddField("duration_mean", durations.GetMean());
+			point.AddField("duration_p50", durations.GetPercentile(50.0));
+			point.AddField("duration_p90", durations.GetPercentile(90.0));
+			point.AddField("duration_p99", durations.GetPercentile(99.0));
+			point.AddField("duration_max", durations.GetMax());
+			aggregate.Durations.Reset();
+		}
+		else {
+			point.AddField("value", aggregate.Value);
+		}
+
+		// Counters start again from zero, gauges keep their value until it is set again
+		if (aggregate.Kind == EMetricKind::Counter) {
+			aggregate.Value = 0.0;
+		}
+		aggregate.bUpdated = false;
+	}
+}
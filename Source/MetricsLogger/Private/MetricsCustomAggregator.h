@@ -0,0 +1,61 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsHistogram.h"
+#include "MetricsModel.h"
+#include "MetricsRecorder.h"
+
+/**
+ * Merges what each thread recorded through FMetricsRecorder per metric name and kind and turns it into custom_metric
+ * points once per interval.
+ *
+ * Timers are logged with their count and percentiles, counters with their total over the interval and gauges with
+ * the latest value set. Metrics with no records in an interval aren't logged, and those no longer registered by any
+ * site are forgotten once their last records are logged.
+ */
+class FMetricsCustomAggregator
+{
+public:
+	FMetricsCustomAggregator();
+
+	// Adds what one thread recorded for a metric since the last drain
+	void Merge(uint32 MetricId, const FMetricsThreadValue& Value);
+
+	// Adds a point for every metric recorded since the last call, and starts a new interval
+	void Summarize(int64 Now, TArray<EventMetaData>& OutPoints);
+
+private:
+	struct FAggregate
+	{
+		// Copied from the registry the first time the metric is recorded
+		FString Name;
+		EMetricKind Kind;
+		FMetricsHistogram Durations;
+		double Value{ 0.0 };
+		// When the gauge value was set
+		uint64 SetCycles{ 0 };
+		bool bUpdated{ false };
+	};
+
+	FAggregate& FindOrAddAggregate(uint32 MetricId);
+
+	// Keyed by metric id, which stands for the metric's name and kind
+	TMap<uint32, FAggregate> Aggregates;
+
+	int64 IntervalStart{ 0 };
+};
@@ -0,0 +1,91 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsDDCSnapshot.h"
+#include "DerivedDataCacheInterface.h"
+#include "DerivedDataCacheUsageStats.h"
+
+#include "MetricsLoggerSettings.h"
+
+#if ENABLE_COOK_STATS
+typedef FCookStats::CallStats::EHitOrMiss EHitOrMiss;
+typedef FCookStats::CallStats::EStatType EStatType;
+
+// Adds up a node's get statistics, and its put statistics if OutBytesWritten is given
+static void AddUsage(const FDerivedDataCacheStatsNode& Node, int64& OutHits, int64& OutMisses, int64& OutGetCycles, int64& OutBytesRead, int64* OutPutCycles, int64* OutBytesWritten)
+{
+	for (const auto& entry : Node.UsageStats) {
+		const FCookStats::CallStats& gets = entry.Value.GetStats;
+		OutHits += gets.GetAccumulatedValueAnyThread(EHitOrMiss::Hit, EStatType::Counter);
+		OutMisses += gets.GetAccumulatedValueAnyThread(EHitOrMiss::Miss, EStatType::Counter);
+		OutGetCycles += gets.GetAccumulatedValueAnyThread(EHitOrMiss::Hit, EStatType::Cycles) + gets.GetAccumulatedValueAnyThread(EHitOrMiss::Miss, EStatType::Cycles);
+		OutBytesRead += gets.GetAccumulatedValueAnyThread(EHitOrMiss::Hit, EStatType::Bytes);
+
+		if (OutPutCycles && OutBytesWritten) {
+			const FCookStats::CallStats& puts = entry.Value.PutStats;
+			*OutPutCycles += puts.GetAccumulatedValueAnyThread(EHitOrMiss::Hit, EStatType::Cycles) + puts.GetAccumulatedValueAnyThread(EHitOrMiss::Miss, EStatType::Cycles);
+			*OutBytesWritten += puts.GetAccumulatedValueAnyThread(EHitOrMiss::Hit, EStatType::Bytes);
+		}
+	}
+}
+
+// Wrapper backends pass requests on to their children, so only the leaves are counted to avoid counting a request twice
+static void AddRemoteUsage(const FDerivedDataCacheStatsNode& Node, FMetricsDDCSnapshot& Snapshot)
+{
+	if (Node.Children.Num() == 0) {
+		if (!Node.IsLocal()) {
+			AddUsage(Node, Snapshot.RemoteGetHits, Snapshot.RemoteGetMisses, Snapshot.RemoteGetCycles, Snapshot.RemoteBytesRead, nullptr, nullptr);
+		}
+		return;
+	}
+
+	for (const auto& child : Node.Children) {
+		AddRemoteUsage(*child, Snapshot);
+	}
+}
+#endif
+
+FMetricsDDCSnapshot FMetricsDDCSnapshot::Capture()
+{
+	FMetricsDDCSnapshot snapshot;
+
+#if ENABLE_COOK_STATS
+	FDerivedDataCacheInterface* ddc = GetDerivedDataCache();
+	if (!ddc || !GetDefault<UMetricsLoggerSettings>()->EnableDDCStats) return snapshot;
+
+	const auto root = ddc->GatherUsageStats();
+	AddUsage(*root, snapshot.GetHits, snapshot.GetMisses, snapshot.GetCycles, snapshot.BytesRead, &snapshot.PutCycles, &snapshot.BytesWritten);
+	AddRemoteUsage(*root, snapshot);
+	snapshot.bValid = true;
+#endif
+
+	return snapshot;
+}
+
+void FMetricsDDCSnapshot::AddDelta(const FMetricsDDCSnapshot& Start, EventMetaData& Event) const
+{
+	if (!bValid || !Start.bValid) return;
+
+	Event.AddField("ddc_get_hits", GetHits - Start.GetHits);
+	Event.AddField("ddc_get_misses", GetMisses - Start.GetMisses);
+	Event.AddField("ddc_get_seconds", FPlatformTime::ToSeconds64(GetCycles - Start.GetCycles));
+	Event.AddField("ddc_bytes_read", BytesRead - Start.BytesRead);
+	Event.AddField("ddc_put_seconds", FPlatformTime::ToSeconds64(PutCycles - Start.PutCycles));
+	Event.AddField("ddc_bytes_written", BytesWritten - Start.BytesWritten);
+	Event.AddField("ddc_remote_get_hits", RemoteGetHits - Start.RemoteGetHits);
+	Event.AddField("ddc_remote_get_misses", RemoteGetMisses - Start.RemoteGetMisses);
+	Event.AddField("ddc_remote_get_seconds", FPlatformTime::ToSeconds64(RemoteGetCycles - Start.RemoteGetCycles));
+	Event.AddField("ddc_remote_bytes_read", RemoteBytesRead - Start.RemoteBytesRead);
+}
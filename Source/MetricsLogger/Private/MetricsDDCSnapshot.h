@@ -0,0 +1,50 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsModel.h"
+
+/**
+ * Derived Data Cache usage totals at a point in time.
+ *
+ * Snapshots are taken when a cook, package or shader session starts and ends, and the difference is added to the
+ * session's event as ddc_ fields, so a slow session can be told apart from one that ran against a cold cache. The
+ * cache is a graph of backends - the overall totals come from its root, which sees every request, and the remote
+ * totals from the leaf backends that aren't local, such as a shared network drive, where a degraded cache shows up.
+ */
+struct FMetricsDDCSnapshot
+{
+	// Returns an invalid snapshot if the cache isn't available, the stats aren't compiled in or they're turned off
+	static FMetricsDDCSnapshot Capture();
+
+	// Adds the usage between Start and this snapshot to Event
+	void AddDelta(const FMetricsDDCSnapshot& Start, EventMetaData& Event) const;
+
+	bool bValid{ false };
+
+	int64 GetHits{ 0 };
+	int64 GetMisses{ 0 };
+	int64 GetCycles{ 0 };
+	int64 BytesRead{ 0 };
+	int64 PutCycles{ 0 };
+	int64 BytesWritten{ 0 };
+
+	int64 RemoteGetHits{ 0 };
+	int64 RemoteGetMisses{ 0 };
+	int64 RemoteGetCycles{ 0 };
+	int64 RemoteBytesRead{ 0 };
+};
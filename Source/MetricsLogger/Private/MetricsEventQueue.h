@@ -0,0 +1,123 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/UnrealMathUtility.h"
+#include "Templates/UniquePtr.h"
+#include "Templates/UnrealTypeTraits.h"
+
+#include <atomic>
+
+/**
+ * Bounded lock-free multi-producer single-consumer ring buffer.
+ *
+ * Any thread may enqueue, only a single thread may dequeue. Each slot carries a sequence number that tells producers
+ * and the consumer whether it is free or filled, so neither side ever takes a lock or allocates after construction.
+ * When the ring is full Enqueue fails rather than blocking the caller.
+ */
+template<typename ElementType>
+class TMetricsEventQueue
+{
+	static_assert(TIsTriviallyDestructible<ElementType>::Value, "Queued elements must be plain data");
+
+public:
+	explicit TMetricsEventQueue(uint32 InCapacity)
+		: Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		, Mask(Capacity - 1)
+		, Slots(MakeUnique<FSlot[]>(Capacity))
+	{
+		for (uint32 i = 0; i < Capacity; i++) {
+			Slots[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Safe to call from any thread. Returns false if the ring is full.
+	bool Enqueue(const ElementType& Item)
+	{
+		uint64 position = EnqueuePosition.load(std::memory_order_relaxed);
+		FSlot* slot;
+
+		for (;;) {
+			slot = &Slots[position & Mask];
+			const uint64 sequence = slot->Sequence.load(std::memory_order_acquire);
+			const int64 difference = (int64)sequence - (int64)position;
+
+			if (difference == 0) {
+				// Slot is free for this position, try to claim it
+				if (EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (difference < 0) {
+				// Consumer hasn't freed this slot yet - the ring is full
+				return false;
+			}
+			else {
+				// Another producer claimed this position first
+				position = EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->Item = Item;
+		slot->Sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Must only be called from the consumer thread. Returns false if the ring is empty.
+	bool Dequeue(ElementType& OutItem)
+	{
+		const uint64 position = DequeuePosition.load(std::memory_order_relaxed);
+		FSlot& slot = Slots[position & Mask];
+		const uint64 sequence = slot.Sequence.load(std::memory_order_acquire);
+
+		if ((int64)sequence - (int64)(position + 1) < 0) {
+			return false;
+		}
+
+		OutItem = slot.Item;
+		slot.Sequence.store(position + Capacity, std::memory_order_release);
+		DequeuePosition.store(position + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Approximate number of queued elements, only meaningful as a hint
+	uint32 Num() const
+	{
+		const uint64 enqueued = EnqueuePosition.load(std::memory_order_relaxed);
+		const uint64 dequeued = DequeuePosition.load(std::memory_order_relaxed);
+		return enqueued > dequeued ? (uint32)(enqueued - dequeued) : 0;
+	}
+
+	uint32 Max() const
+	{
+		return Capacity;
+	}
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint64> Sequence;
+		ElementType Item;
+	};
+
+	const uint32 Capacity;
+	const uint32 Mask;
+	TUniquePtr<FSlot[]> Slots;
+
+	// Keep the producer and consumer positions on separate cache lines
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePosition{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> DequeuePosition{ 0 };
+};
@@ -0,0 +1,117 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsHistogram.h"
+
+// Values below 2^LINEAR_BITS get a bucket each, every power of two above is split into 2^(LINEAR_BITS - 1) buckets
+const int32 LINEAR_BITS = 7;
+const int32 SUB_BUCKETS = 1 << (LINEAR_BITS - 1);
+
+// Recorded values are whole nanoseconds
+const double UNITS_PER_SECOND = 1000000000.0;
+
+void FMetricsHistogram::Record(double Seconds)
+{
+	const uint64 value = (uint64)FMath::Clamp(Seconds * UNITS_PER_SECOND + 0.5, 0.0, (double)MAX_int64);
+
+	const int32 index = GetBucketIndex(value);
+	if (index >= Buckets.Num()) {
+		Buckets.SetNumZeroed(index + 1);
+	}
+
+	Buckets[index]++;
+	Count++;
+	MinValue = FMath::Min(MinValue, value);
+	MaxValue = FMath::Max(MaxValue, value);
+	Sum += Seconds;
+}
+
+void FMetricsHistogram::Merge(const FMetricsHistogram& Other)
+{
+	if (Other.Count == 0) return;
+
+	if (Other.Buckets.Num() > Buckets.Num()) {
+		Buckets.SetNumZeroed(Other.Buckets.Num());
+	}
+	for (int32 i = 0; i < Other.Buckets.Num(); i++) {
+		Buckets[i] += Other.Buckets[i];
+	}
+
+	Count += Other.Count;
+	MinValue = FMath::Min(MinValue, Other.MinValue);
+	MaxValue = FMath::Max(MaxValue, Other.MaxValue);
+	Sum += Other.Sum;
+}
+
+void FMetricsHistogram::Reset()
+{
+	// Keep the buckets allocated, the next interval will most likely need as many
+	FMemory::Memzero(Buckets.GetData(), Buckets.Num() * sizeof(uint64));
+	Count = 0;
+	MinValue = MAX_uint64;
+	MaxValue = 0;
+	Sum = 0.0;
+}
+
+double FMetricsHistogram::GetMin() const
+{
+	return Count > 0 ? MinValue / UNITS_PER_SECOND : 0.0;
+}
+
+double FMetricsHistogram::GetMax() const
+{
+	return MaxValue / UNITS_PER_SECOND;
+}
+
+double FMetricsHistogram::GetMean() const
+{
+	return Count > 0 ? Sum / Count : 0.0;
+}
+
+double FMetricsHistogram::GetPercentile(double Percentile) const
+{
+	if (Count == 0) return 0.0;
+
+	// Rank of the value we're after, 1 based
+	const uint64 rank = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0, 100.0) / 100.0 * Count));
+
+	uint64 seen = 0;
+	for (int32 i = 0; i < Buckets.Num(); i++) {
+		seen += Buckets[i];
+		if (seen >= rank) {
+			// Every value in a bucket is reported as its largest, but never beyond what was actually recorded
+			return FMath::Clamp(GetBucketUpperBound(i), MinValue, MaxValue) / UNITS_PER_SECOND;
+		}
+	}
+	return GetMax();
+}
+
+int32 FMetricsHistogram::GetBucketIndex(uint64 Value)
+{
+	if (Value < (1 << LINEAR_BITS)) return (int32)Value;
+
+	// Keep the top LINEAR_BITS - 1 bits below the leading one
+	const int32 shift = (int32)FPlatformMath::FloorLog2_64(Value) - (LINEAR_BITS - 1);
+	return shift * SUB_BUCKETS + (int32)(Value >> shift);
+}
+
+uint64 FMetricsHistogram::GetBucketUpperBound(int32 Index)
+{
+	if (Index < (1 << LINEAR_BITS)) return Index;
+
+	const int32 shift = Index / SUB_BUCKETS - 1;
+	const uint64 mantissa = Index - shift * SUB_BUCKETS;
+	return ((mantissa + 1) << shift) - 1;
+}
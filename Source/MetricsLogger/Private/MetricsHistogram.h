@@ -0,0 +1,55 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Histogram of durations with log-linear buckets, in the style of an HDR histogram.
+ *
+ * Values are recorded in whole nanoseconds, so the shortest scopes timed through FMetricsRecorder still register.
+ * Below 128 each value has its own bucket, above that every power of two is split into 64 buckets, so any percentile
+ * is accurate to within about 1.5% of the value whatever its magnitude. Buckets are only allocated up to the largest
+ * value recorded - under a kilobyte for microsecond scopes and some 20 kilobytes for durations of several hours.
+ */
+class FMetricsHistogram
+{
+public:
+	// Records a duration in seconds
+	void Record(double Seconds);
+
+	// Adds every value recorded by Other
+	void Merge(const FMetricsHistogram& Other);
+
+	void Reset();
+
+	uint64 GetCount() const { return Count; }
+	double GetMin() const;
+	double GetMax() const;
+	double GetMean() const;
+
+	// Duration in seconds that Percentile percent of the recorded values are at or below
+	double GetPercentile(double Percentile) const;
+
+private:
+	static int32 GetBucketIndex(uint64 Value);
+	static uint64 GetBucketUpperBound(int32 Index);
+
+	TArray<uint64> Buckets;
+	uint64 Count{ 0 };
+	uint64 MinValue{ MAX_uint64 };
+	uint64 MaxValue{ 0 };
+	double Sum{ 0.0 };
+};
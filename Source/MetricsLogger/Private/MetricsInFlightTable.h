@@ -0,0 +1,121 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-size open-addressed map of operations that have started but not finished yet.
+ *
+ * There are only ever a handful of operations in flight, so the entries live inline in a small power-of-two table
+ * and collisions are resolved by linear probing. Removal shifts the following entries of the probe run back instead
+ * of leaving tombstones, so lookups never degrade however many operations come and go. Key 0 marks an empty slot.
+ */
+template<typename ValueType, int32 Capacity = 16>
+class TMetricsInFlightTable
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	ValueType* Find(uint32 Key)
+	{
+		const int32 index = FindIndex(ToSlotKey(Key));
+		return index != INDEX_NONE ? &Values[index] : nullptr;
+	}
+
+	// Adds a default value for Key. Returns nullptr if Key is already in flight or the table is full.
+	ValueType* Add(uint32 Key)
+	{
+		const uint32 slotKey = ToSlotKey(Key);
+		if (Count == Capacity || FindIndex(slotKey) != INDEX_NONE) return nullptr;
+
+		int32 index = slotKey & Mask;
+		while (Keys[index] != 0) {
+			index = (index + 1) & Mask;
+		}
+
+		Keys[index] = slotKey;
+		Values[index] = ValueType();
+		Count++;
+		return &Values[index];
+	}
+
+	// Moves the value for Key out of the table. Returns false if Key isn't in flight.
+	bool Remove(uint32 Key, ValueType& OutValue)
+	{
+		const int32 index = FindIndex(ToSlotKey(Key));
+		if (index == INDEX_NONE) return false;
+
+		OutValue = MoveTemp(Values[index]);
+		RemoveAt(index);
+		return true;
+	}
+
+	// Removes every value Predicate returns true for, passing each to OnRemoved
+	void RemoveAll(TFunctionRef<bool(const ValueType&)> Predicate, TFunctionRef<void(ValueType&)> OnRemoved)
+	{
+		// Removal shifts entries around, so start over from the first slot after each one
+		for (int32 index = 0; index < Capacity; index++) {
+			if (Keys[index] != 0 && Predicate(Values[index])) {
+				ValueType value = MoveTemp(Values[index]);
+				RemoveAt(index);
+				OnRemoved(value);
+				index = -1;
+			}
+		}
+	}
+
+	int32 Num() const { return Count; }
+
+private:
+	static const int32 Mask = Capacity - 1;
+
+	static uint32 ToSlotKey(uint32 Key)
+	{
+		return Key != 0 ? Key : 1;
+	}
+
+	int32 FindIndex(uint32 SlotKey) const
+	{
+		int32 index = SlotKey & Mask;
+		for (int32 probes = 0; probes < Capacity && Keys[index] != 0; probes++) {
+			if (Keys[index] == SlotKey) return index;
+			index = (index + 1) & Mask;
+		}
+		return INDEX_NONE;
+	}
+
+	void RemoveAt(int32 Index)
+	{
+		int32 hole = Index;
+		Keys[hole] = 0;
+		Values[hole] = ValueType();
+		Count--;
+
+		// Pull back every entry whose home slot is at or before the hole so it stays reachable from there
+		for (int32 next = (hole + 1) & Mask; Keys[next] != 0; next = (next + 1) & Mask) {
+			const int32 home = Keys[next] & Mask;
+			if (((next - home) & Mask) >= ((next - hole) & Mask)) {
+				Keys[hole] = Keys[next];
+				Values[hole] = MoveTemp(Values[next]);
+				Keys[next] = 0;
+				hole = next;
+			}
+		}
+	}
+
+	uint32 Keys[Capacity] = {};
+	ValueType Values[Capacity];
+	int32 Count{ 0 };
+};
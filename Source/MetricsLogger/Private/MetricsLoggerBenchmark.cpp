@@ -0,0 +1,357 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsLoggerBenchmark.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "Misc/Parse.h"
+
+#include "IMetricsSink.h"
+#include "LineProtocolWriter.h"
+#include "MetricsClock.h"
+#include "MetricsLogCategory.h"
+#include "MetricsLoggerEventMonitor.h"
+#include "MetricsLoggerPipeline.h"
+
+#include <atomic>
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * Allocator that forwards to the real one and counts the allocations made by a single thread.
+ *
+ * It is only swapped in for the duration of a benchmark. Other threads still go through it while it is installed but
+ * their allocations aren't counted.
+ */
+class FMetricsAllocationCounter : public FMalloc
+{
+public:
+	void Begin()
+	{
+		Inner = GMalloc;
+		ThreadId = FPlatformTLS::GetCurrentThreadId();
+		NumAllocations = 0;
+		GMalloc = this;
+	}
+
+	uint64 End()
+	{
+		GMalloc = Inner;
+		return NumAllocations;
+	}
+
+	// FMalloc overrides
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return Inner->Malloc(Count, Alignment);
+	}
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count > 0) {
+			CountAllocation();
+		}
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		Inner->Trim(bTrimThreadCaches);
+	}
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		Inner->SetupTLSCachesOnCurrentThread();
+	}
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		Inner->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("MetricsAllocationCounter");
+	}
+
+private:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == ThreadId) {
+			NumAllocations++;
+		}
+	}
+
+	FMalloc* Inner{ nullptr };
+	uint32 ThreadId{ 0 };
+	uint64 NumAllocations{ 0 };
+};
+
+// Kept alive for the whole process - another thread may still be calling into it just after it is uninstalled
+static FMetricsAllocationCounter AllocationCounter;
+
+// Points per batch, matching the default batching threshold
+const int32 BENCHMARK_BATCH_POINTS = 100;
+
+static void BenchmarkSerializer(const TArray<FString>& Args)
+{
+	const int32 numPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+
+	// Metadata with every character that needs escaping
+	TArray<FLineProtocolWriter::FTag> tags;
+	tags.Emplace(TEXT("project_name"), TEXT("Benchmark Project"));
+	tags.Emplace(TEXT("cpu_model"), TEXT("Intel(R) Core(TM) i9-9900K CPU @ 3.60GHz"));
+	tags.Emplace(TEXT("gpu_model"), TEXT("NVIDIA GeForce RTX 2080, Ti"));
+	tags.Emplace(TEXT("machine_name"), TEXT("build=agent 01"));
+
+	FLineProtocolWriter writer;
+	writer.Initialize(tags, TEXT("Bench User"));
+
+	EventMetaData data;
+	data.startTime = FMetricsClock::Now();
+
+	// Warm up so the buffer reaches the size of a full batch
+	TArray<uint8> buffer;
+	for (int32 i = 0; i < BENCHMARK_BATCH_POINTS; i++) {
+		writer.Write(data, 1, buffer);
+	}
+
+	AllocationCounter.Begin();
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	uint64 numBytes = 0;
+
+	for (int32 i = 0; i < numPoints; i++) {
+		if (i % BENCHMARK_BATCH_POINTS == 0) {
+			numBytes += buffer.Num();
+			buffer.Reset();
+		}
+
+		data.type = (LogEventTypeEnum)(1 + i % ((int32)LogEventTypeEnum::NUM - 1));
+		data.success = (i & 1) != 0;
+		data.duration = i * 0.37;
+		data.finishTime = data.startTime + FMetricsClock::FromSeconds(data.duration);
+		writer.Write(data, 1, buffer);
+	}
+
+	const double seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - startCycles);
+	const uint64 numAllocations = AllocationCounter.End();
+	numBytes += buffer.Num();
+
+	UE_LOG(MetricsLog, Display, TEXT("Serialized %d points in %.2f ms - %.1f ns/point, %.1f bytes/point, %llu heap allocations"),
+		numPoints, seconds * 1000.0, seconds * 1e9 / numPoints, (double)numBytes / numPoints, numAllocations);
+}
+
+static FAutoConsoleCommand BenchmarkSerializerCommand(
+	TEXT("MetricsLogger.Benchmark.Serializer"),
+	TEXT("Serializes synthetic points into line protocol and reports the time, size and heap allocations per point. Usage: MetricsLogger.Benchmark.Serializer [NumPoints]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkSerializer));
+
+// What reached the benchmark sink - shared so it can still be read once the pipeline has destroyed the sink
+struct FBenchmarkCounts
+{
+	std::atomic<uint64> NumPoints{ 0 };
+	std::atomic<uint64> NumBytes{ 0 };
+};
+typedef TSharedRef<FBenchmarkCounts, ESPMode::ThreadSafe> FBenchmarkCountsRef;
+
+/**
+ * Sink standing in for the network. It only counts the points and bytes that would have been sent, so the benchmark
+ * measures the logger rather than the endpoint.
+ */
+class FBenchmarkSink : public IMetricsSink
+{
+public:
+	FBenchmarkSink(const FBenchmarkCountsRef& InCounts)
+		: IMetricsSink(TEXT("Benchmark"), 1024, SinkBackpressure::DropNewest)
+		, Counts(InCounts)
+	{
+		StartThread();
+	}
+
+	virtual ~FBenchmarkSink()
+	{
+		StopThread();
+	}
+
+protected:
+	virtual void Write(const FMetricsBatch& Batch) override
+	{
+		Counts->NumBytes.fetch_add(Batch.LineProtocol.Num(), std::memory_order_relaxed);
+		Counts->NumPoints.fetch_add(Batch.Events.Num(), std::memory_order_release);
+	}
+
+private:
+	FBenchmarkCountsRef Counts;
+};
+
+// Events handed to the monitor before waiting for the pipeline to catch up - below the event queue's capacity so
+// none are dropped however fast they come
+const int32 BENCHMARK_BURST_EVENTS = 2048;
+
+// Longest to wait for the pipeline to deliver a burst before giving up
+const double BENCHMARK_DRAIN_TIMEOUT = 30.0;
+
+struct FBenchmarkEvent
+{
+	FString Name;
+	TArray<FAnalyticsEventAttribute> Attrs;
+	// Whether the monitor logs a point for it
+	bool bLogsPoint;
+};
+
+// A mix of the editor events the monitor handles - builds that carry their own duration, and packaging runs paired
+// from their start and stop events by platform
+static TArray<FBenchmarkEvent> MakeBenchmarkEvents()
+{
+	TArray<FBenchmarkEvent> events;
+	for (const TCHAR* platform : { TEXT("Windows"), TEXT("Linux"), TEXT("Android"), TEXT("IOS") }) {
+		events.Add({ TEXT("Editor.Modules.Recompile"), { FAnalyticsEventAttribute(TEXT("Duration"), TEXT("12.5")), FAnalyticsEventAttribute(TEXT("Result"), TEXT("Succeeded")) }, true });
+		events.Add({ TEXT("Editor.Package.Start"), { FAnalyticsEventAttribute(TEXT("Platform"), platform) }, false });
+		events.Add({ TEXT("Editor.Package.Completed"), { FAnalyticsEventAttribute(TEXT("Platform"), platform) }, true });
+	}
+	return events;
+}
+
+// Flushes the pipeline and waits until the sink has seen NumPoints in total
+static bool WaitForPoints(FMetricsLoggerPipeline& Pipeline, const FBenchmarkCounts& Counts, uint64 NumPoints)
+{
+	Pipeline.Flush();
+
+	const double deadline = FPlatformTime::Seconds() + BENCHMARK_DRAIN_TIMEOUT;
+	while (Counts.NumPoints.load(std::memory_order_acquire) < NumPoints) {
+		if (FPlatformTime::Seconds() > deadline) {
+			UE_LOG(MetricsLog, Error, TEXT("Pipeline delivered %llu of %llu points before timing out."), Counts.NumPoints.load(), NumPoints);
+			return false;
+		}
+		FPlatformProcess::Sleep(0.0001f);
+	}
+	return true;
+}
+
+bool MetricsLoggerBenchmark::RunPipeline(const TCHAR* Params)
+{
+	int32 numEvents = 100000;
+	FParse::Value(Params, TEXT("Events="), numEvents);
+	numEvents = FMath::Max(numEvents, 1);
+
+	// Regression thresholds - anything not given isn't checked
+	float minEventsPerSec = 0.0f;
+	float maxP99Microseconds = 0.0f;
+	float maxAllocationsPerEvent = -1.0f;
+	float maxBytesPerPoint = 0.0f;
+	FParse::Value(Params, TEXT("MinEventsPerSec="), minEventsPerSec);
+	FParse::Value(Params, TEXT("MaxP99Us="), maxP99Microseconds);
+	FParse::Value(Params, TEXT("MaxAllocsPerEvent="), maxAllocationsPerEvent);
+	FParse::Value(Params, TEXT("MaxBytesPerPoint="), maxBytesPerPoint);
+
+	const TArray<FBenchmarkEvent> events = MakeBenchmarkEvents();
+
+	// Logging is on whatever the project settings say, and nothing but the events themselves is logged
+	TSharedRef<FMetricsSettingsSnapshot, ESPMode::ThreadSafe> settings = MakeShared<FMetricsSettingsSnapshot, ESPMode::ThreadSafe>(*FMetricsSettings::Get());
+	settings->EnableLogging = true;
+	settings->EnableSummaries = false;
+	settings->EnableSelfTelemetry = false;
+
+	FBenchmarkCountsRef counts = MakeShared<FBenchmarkCounts, ESPMode::ThreadSafe>();
+	TArray<TUniquePtr<IMetricsSink>> sinks;
+	sinks.Add(MakeUnique<FBenchmarkSink>(counts));
+	FMetricsLoggerPipeline pipeline(MoveTemp(sinks), settings);
+	FMetricsLoggerEventMonitor monitor(pipeline);
+
+	// Warm up so the serializer, batches and in-flight table are set up before anything is measured
+	uint64 numPoints = 0;
+	for (const FBenchmarkEvent& event : events) {
+		monitor.ProcessEvent(event.Name, event.Attrs, false);
+		numPoints += event.bLogsPoint ? 1 : 0;
+	}
+	if (!WaitForPoints(pipeline, *counts, numPoints)) return false;
+	const uint64 warmupPoints = numPoints;
+	const uint64 warmupBytes = counts->NumBytes.load();
+
+	TArray<uint64> latencies;
+	latencies.SetNumUninitialized(numEvents);
+	uint64 numAllocations = 0;
+
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	for (int32 i = 0; i < numEvents;) {
+		const int32 burstEnd = FMath::Min(i + BENCHMARK_BURST_EVENTS, numEvents);
+
+		AllocationCounter.Begin();
+		for (; i < burstEnd; i++) {
+			const FBenchmarkEvent& event = events[i % events.Num()];
+			const uint64 eventStartCycles = FPlatformTime::Cycles64();
+			monitor.ProcessEvent(event.Name, event.Attrs, false);
+			latencies[i] = FPlatformTime::Cycles64() - eventStartCycles;
+			numPoints += event.bLogsPoint ? 1 : 0;
+		}
+		numAllocations += AllocationCounter.End();
+
+		if (!WaitForPoints(pipeline, *counts, numPoints)) return false;
+	}
+	const double seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - startCycles);
+
+	latencies.Sort();
+	const double p50Microseconds = FPlatformTime::ToMilliseconds64(latencies[numEvents / 2]) * 1000.0;
+	const double p99Microseconds = FPlatformTime::ToMilliseconds64(latencies[FMath::Min((int32)(numEvents * 0.99), numEvents - 1)]) * 1000.0;
+	const double eventsPerSec = numEvents / seconds;
+	const double allocationsPerEvent = (double)numAllocations / numEvents;
+	const double bytesPerPoint = (double)(counts->NumBytes.load() - warmupBytes) / FMath::Max<uint64>(numPoints - warmupPoints, 1);
+
+	UE_LOG(MetricsLog, Display, TEXT("Processed %d events into %llu points in %.2f ms - %.0f events/s, ProcessEvent p50 %.2f us p99 %.2f us, %.2f heap allocations/event, %.1f bytes/point"),
+		numEvents, numPoints - warmupPoints, seconds * 1000.0, eventsPerSec, p50Microseconds, p99Microseconds, allocationsPerEvent, bytesPerPoint);
+
+	bool bPassed = true;
+	if (minEventsPerSec > 0.0f && eventsPerSec < minEventsPerSec) {
+		UE_LOG(MetricsLog, Error, TEXT("Regression: %.0f events/s is below the minimum of %.0f."), eventsPerSec, minEventsPerSec);
+		bPassed = false;
+	}
+	if (maxP99Microseconds > 0.0f && p99Microseconds > maxP99Microseconds) {
+		UE_LOG(MetricsLog, Error, TEXT("Regression: ProcessEvent p99 of %.2f us is above the maximum of %.2f us."), p99Microseconds, maxP99Microseconds);
+		bPassed = false;
+	}
+	if (maxAllocationsPerEvent >= 0.0f && allocationsPerEvent > maxAllocationsPerEvent) {
+		UE_LOG(MetricsLog, Error, TEXT("Regression: %.2f heap allocations/event is above the maximum of %.2f."), allocationsPerEvent, maxAllocationsPerEvent);
+		bPassed = false;
+	}
+	if (maxBytesPerPoint > 0.0f && bytesPerPoint > maxBytesPerPoint) {
+		UE_LOG(MetricsLog, Error, TEXT("Regression: %.1f bytes/point is above the maximum of %.1f."), bytesPerPoint, maxBytesPerPoint);
+		bPassed = false;
+	}
+	return bPassed;
+}
+
+static FAutoConsoleCommand BenchmarkPipelineCommand(
+	TEXT("MetricsLogger.Benchmark.Pipeline"),
+	TEXT("Drives synthetic editor analytics events through the event monitor and pipeline and reports events/s, ProcessEvent latency, heap allocations per event and bytes per point. ")
+	TEXT("Usage: MetricsLogger.Benchmark.Pipeline [Events=N] [MinEventsPerSec=N] [MaxP99Us=N] [MaxAllocsPerEvent=N] [MaxBytesPerPoint=N]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+		MetricsLoggerBenchmark::RunPipeline(*FString::Join(Args, TEXT(" ")));
+		}));
+
+#endif // !UE_BUILD_SHIPPING
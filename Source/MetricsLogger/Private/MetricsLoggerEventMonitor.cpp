@@ -15,6 +15,10 @@
 
 #include "MetricsLoggerEventMonitor.h"
 #include "MetricsLogCategory.h"
+#include "MetricsClock.h"
+#include "MetricsLoggerSettings.h"
+#include "MetricsSelfStats.h"
+#include "Misc/ConfigCacheIni.h"
 
 // Event Identifiers
 const TCHAR* const RECOMPILE_EVENT = TEXT("Editor.Modules.Recompile");
@@ -27,7 +31,36 @@ const TCHAR* const PACKAGE_START_EVENT = TEXT("Editor.Package.Start");
 const TCHAR* const PACKAGE_STOP_EVENT = TEXT("Editor.Package.Completed");
 const TCHAR* const PACKAGE_FAILED_EVENT = TEXT("Editor.Package.Failed");
 
-FMetricsLoggerEventMonitor::FMetricsLoggerEventMonitor(IMetricsLogger& logger): MetricsLogger(logger)
+DECLARE_CYCLE_STAT(TEXT("Process Event"), STAT_MetricsLogger_ProcessEvent, STATGROUP_MetricsLogger);
+DECLARE_CYCLE_STAT(TEXT("Monitor Tick"), STAT_MetricsLogger_Tick, STATGROUP_MetricsLogger);
+
+// Platform an editor analytics event is for, if it has one
+static FString GetPlatform(const TArray<FAnalyticsEventAttribute>& Attrs)
+{
+	for (const FAnalyticsEventAttribute& attr : Attrs) {
+		if (attr.GetName() == TEXT("Platform")) {
+			return attr.GetValue();
+		}
+	}
+	return FString();
+}
+
+// Key pairing the start of an operation with its stop or failure
+static uint32 GetEventKey(LogEventTypeEnum type, const FString& platform)
+{
+	return HashCombine(GetTypeHash((int32)type), GetTypeHash(platform));
+}
+
+// Number of local shader compile workers, worked out the same way as the shader compiling manager does
+static int32 GetShaderWorkerCount()
+{
+	int32 numUnusedThreads = 1;
+	GConfig->GetInt(TEXT("DevOptions.Shaders"), TEXT("NumUnusedShaderCompilingThreads"), numUnusedThreads, GEngineIni);
+
+	return FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() - numUnusedThreads);
+}
+
+FMetricsLoggerEventMonitor::FMetricsLoggerEventMonitor(IMetricsLogger& logger): MetricsLogger(logger), CookPhases(logger), FrameRecorder(logger), StartupTracker(logger)
 {
 	// Store map of functions to call for each event fired that we care about
 
@@ -58,14 +91,37 @@ FMetricsLoggerEventMonitor::FMetricsLoggerEventMonitor(IMetricsLogger& logger):
 		OnPackageFailed(EventName, Attrs, bJson);
 	});
 
+	ShaderWorkerCount = GetShaderWorkerCount();
+
 	FOnGlobalShadersCompilation& shaderCompileDelegate = GetOnGlobalShaderCompilation();
-	shaderCompileDelegate.AddLambda([this]() {
+	ShaderCompileHandle = shaderCompileDelegate.AddLambda([this]() {
 		OnShaderStart();
 		});
+
+	// The monitor is created once the engine is up, so the whole cook is still ahead of us
+	if (IsRunningCommandlet() && FCString::Stristr(FCommandLine::Get(), TEXT("-run=cook"))) {
+		cookCommandlet = true;
+		OnCookStart(COOK_START_EVENT, TArray<FAnalyticsEventAttribute>(), false);
+	}
+}
+
+FMetricsLoggerEventMonitor::~FMetricsLoggerEventMonitor()
+{
+	GetOnGlobalShaderCompilation().Remove(ShaderCompileHandle);
+
+	if (cookCommandlet) {
+		LogCookEvent(TArray<FAnalyticsEventAttribute>(), !GIsCriticalError);
+	}
+
+	// Anything else still running won't be seen finishing
+	ExpireEvents(MAX_int64);
 }
 
 void FMetricsLoggerEventMonitor::ProcessEvent(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
 {
+	SCOPE_CYCLE_COUNTER(STAT_MetricsLogger_ProcessEvent);
+	FMetricsSelfStats::FGameThreadScope selfStatsScope;
+
 	// Log event name
 	UE_LOG(MetricsLog, Verbose, TEXT("FEngineAnalytics Event fired: %s"), *EventName);
 
@@ -76,11 +132,25 @@ void FMetricsLoggerEventMonitor::ProcessEvent(const FString& EventName, const TA
 
 void FMetricsLoggerEventMonitor::Tick(float DeltaTime)
 {
-	// Need to do poll the ShaderManager to see when it finishes compiling (unfortunately)
-	if (shaderCompileInProgress && GShaderCompilingManager && !GShaderCompilingManager->IsCompiling()) {
-		LogShaderEvent();
+	SCOPE_CYCLE_COUNTER(STAT_MetricsLogger_Tick);
+	FMetricsSelfStats::FGameThreadScope selfStatsScope;
+
+	FrameRecorder.Tick(DeltaTime);
+	StartupTracker.Tick();
+
+	if (InFlightEvents.Num() > 0) {
+		ExpireEvents(FMetricsClock::Now() - FMetricsClock::FromSeconds(GetDefault<UMetricsLoggerSettings>()->EventTimeout * 60.0));
 	}
 
+	// The shader compiling manager has no notifications for jobs finishing, so it is sampled
+	// each frame while a compile is in flight - the monitor doesn't tick at all otherwise
+	if (shaderCompileInProgress && GShaderCompilingManager) {
+		SampleShaderJobs(DeltaTime);
+
+		if (!GShaderCompilingManager->IsCompiling()) {
+			LogShaderEvent();
+		}
+	}
 }
 
 void FMetricsLoggerEventMonitor::OnRecompile(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
@@ -103,9 +173,9 @@ void FMetricsLoggerEventMonitor::OnRecompile(const FString& EventName, const TAr
 	if (!duration.IsEmpty()) {
 		EventMetaData eventData = EventMetaData();
 		eventData.type = LogEventTypeEnum::BUILD;
-		eventData.finishTime = FDateTime::UtcNow();
-		eventData.duration = FCString::Atoi(*duration);
-		eventData.startTime = eventData.finishTime - FTimespan(0, 0, eventData.duration);
+		eventData.finishTime = FMetricsClock::Now();
+		eventData.duration = FCString::Atod(*duration);
+		eventData.startTime = eventData.finishTime - FMetricsClock::FromSeconds(eventData.duration);
 		eventData.success = success;
 		MetricsLogger.Log(eventData);
 	}
@@ -113,13 +183,7 @@ void FMetricsLoggerEventMonitor::OnRecompile(const FString& EventName, const TAr
 
 void FMetricsLoggerEventMonitor::OnCookStart(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
 {
-	// Don't register a new event if there's one already active - a double event will result in a failure anyway
-	if (!cookInProgress) {
-		CurrentCookEvent = EventMetaData();
-		CurrentCookEvent.startTime = FDateTime::UtcNow();
-		CurrentCookEvent.type = LogEventTypeEnum::COOK;
-		cookInProgress = true;
-	}
+	StartEvent(LogEventTypeEnum::COOK, Attrs);
 }
 
 void FMetricsLoggerEventMonitor::OnCookStop(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
@@ -134,28 +198,13 @@ void FMetricsLoggerEventMonitor::OnCookFailed(const FString& EventName, const TA
 
 void FMetricsLoggerEventMonitor::LogCookEvent(const TArray<FAnalyticsEventAttribute>& Attrs, bool success)
 {
-	// Ignore the second failure when someone attempts to cook twice
-	if (cookInProgress) {
-		CurrentCookEvent.finishTime = FDateTime::UtcNow();
-		CurrentCookEvent.duration = (CurrentCookEvent.finishTime - CurrentCookEvent.startTime).GetTotalSeconds();
-		CurrentCookEvent.success = success;
-		MetricsLogger.Log(CurrentCookEvent);
-
-		cookInProgress = false;
-	}
+	FinishEvent(LogEventTypeEnum::COOK, Attrs, success);
 }
 
 
 void FMetricsLoggerEventMonitor::OnPackageStart(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
 {
-	// Don't register a new event if there's one already active - a double event will result in a failure anyway
-	if (!packageInProgress) {
-		packageInProgress = true;
-
-		CurrentPackageEvent = EventMetaData();
-		CurrentPackageEvent.startTime = FDateTime::UtcNow();
-		CurrentPackageEvent.type = LogEventTypeEnum::PACKAGE;
-	}
+	StartEvent(LogEventTypeEnum::PACKAGE, Attrs);
 }
 
 void FMetricsLoggerEventMonitor::OnPackageStop(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson)
@@ -170,36 +219,129 @@ void FMetricsLoggerEventMonitor::OnPackageFailed(const FString& EventName, const
 
 void FMetricsLoggerEventMonitor::LogPackageEvent(const TArray<FAnalyticsEventAttribute>& Attrs, bool success)
 {
-	// Ignore the second failure when someone attempts to package twice
-	if (packageInProgress) {
-		packageInProgress = false;
+	FinishEvent(LogEventTypeEnum::PACKAGE, Attrs, success);
+}
+
+void FMetricsLoggerEventMonitor::StartEvent(LogEventTypeEnum type, const TArray<FAnalyticsEventAttribute>& Attrs)
+{
+	const FString platform = GetPlatform(Attrs);
+
+	// A second start for the same platform while one is active will result in a failure anyway
+	InFlightEvent* inFlight = InFlightEvents.Add(GetEventKey(type, platform));
+	if (!inFlight) {
+		UE_LOG(MetricsLog, Verbose, TEXT("Ignoring %s start for '%s' - it is already in flight or too many operations are."), *MetricsLoggerUtils::LogEventTypeToFString(type), *platform);
+		return;
+	}
 
-		CurrentPackageEvent.finishTime = FDateTime::UtcNow();
-		CurrentPackageEvent.duration = (CurrentPackageEvent.finishTime - CurrentPackageEvent.startTime).GetTotalSeconds();
-		CurrentPackageEvent.success = success;
-		MetricsLogger.Log(CurrentPackageEvent);
+	inFlight->ddcStart = FMetricsDDCSnapshot::Capture();
+	inFlight->resources = ResourceSampler.BeginSession();
+	EventMetaData* eventData = &inFlight->eventData;
+	eventData->startTime = FMetricsClock::Now();
+	eventData->type = type;
+	eventData->spanId = MetricsLoggerUtils::NewSpanId();
+	if (!platform.IsEmpty()) {
+		eventData->AddTag("platform", *platform);
+	}
+
+	// Only one cook at a time can be broken down into phases - the engine delegates don't say which cook they belong to
+	if (type == LogEventTypeEnum::COOK && !CookPhases.IsActive()) {
+		CookPhases.Begin(eventData->spanId);
+	}
+}
 
+void FMetricsLoggerEventMonitor::FinishEvent(LogEventTypeEnum type, const TArray<FAnalyticsEventAttribute>& Attrs, bool success)
+{
+	// Ignore stops without a start, such as the second failure when someone attempts to cook twice
+	InFlightEvent inFlight;
+	if (InFlightEvents.Remove(GetEventKey(type, GetPlatform(Attrs)), inFlight)) {
+		LogFinishedEvent(inFlight, FMetricsClock::Now(), success);
 	}
 }
 
+void FMetricsLoggerEventMonitor::LogFinishedEvent(InFlightEvent& inFlight, int64 finishTime, bool success)
+{
+	EventMetaData& eventData = inFlight.eventData;
+	eventData.finishTime = finishTime;
+	eventData.duration = FMetricsClock::ToSeconds(eventData.finishTime - eventData.startTime);
+	eventData.success = success;
+	FMetricsDDCSnapshot::Capture().AddDelta(inFlight.ddcStart, eventData);
+	ResourceSampler.EndSession(inFlight.resources, eventData);
+
+	if (eventData.type == LogEventTypeEnum::COOK) {
+		CookPhases.End(eventData);
+	}
+	MetricsLogger.Log(eventData);
+}
+
+void FMetricsLoggerEventMonitor::ExpireEvents(int64 olderThan)
+{
+	const int64 now = FMetricsClock::Now();
+
+	// Operations whose stop event never came are logged as aborted failures
+	InFlightEvents.RemoveAll(
+		[olderThan](const InFlightEvent& inFlight) { return inFlight.eventData.startTime < olderThan; },
+		[this, now](InFlightEvent& inFlight) {
+			UE_LOG(MetricsLog, Verbose, TEXT("Logging %s as aborted."), *MetricsLoggerUtils::LogEventTypeToFString(inFlight.eventData.type));
+			inFlight.eventData.AddTag("status", TEXT("aborted"));
+			LogFinishedEvent(inFlight, now, false);
+		});
+}
+
 void FMetricsLoggerEventMonitor::OnShaderStart()
 {
+	// Global shaders can be kicked off again while a compile is still running - keep the current session going
+	if (shaderCompileInProgress) return;
+
 	CurrentShaderEvent = EventMetaData();
-	CurrentShaderEvent.startTime = FDateTime::UtcNow();
+	CurrentShaderEvent.startTime = FMetricsClock::Now();
 	CurrentShaderEvent.type = LogEventTypeEnum::SHADER;
+	CurrentShaderEvent.spanId = MetricsLoggerUtils::NewSpanId();
 
+	CurrentShaderStats = ShaderSessionStats();
+	CurrentShaderDDCStart = FMetricsDDCSnapshot::Capture();
+	CurrentShaderResources = ResourceSampler.BeginSession();
+	ShaderHotspots.BeginSession();
 	shaderCompileInProgress = true;
 }
 
+void FMetricsLoggerEventMonitor::SampleShaderJobs(float DeltaTime)
+{
+	const int32 remainingJobs = GShaderCompilingManager->GetNumRemainingJobs();
+
+	// Any increase since the last sample is newly submitted jobs
+	if (remainingJobs > CurrentShaderStats.lastRemainingJobs) {
+		CurrentShaderStats.totalJobs += remainingJobs - CurrentShaderStats.lastRemainingJobs;
+	}
+	CurrentShaderStats.lastRemainingJobs = remainingJobs;
+	CurrentShaderStats.peakRemainingJobs = FMath::Max(CurrentShaderStats.peakRemainingJobs, remainingJobs);
+
+	// Workers are busy as long as there are at least as many jobs left as workers
+	CurrentShaderStats.busyWorkerSeconds += FMath::Min(remainingJobs, ShaderWorkerCount) * DeltaTime;
+	CurrentShaderStats.sampledSeconds += DeltaTime;
+}
+
 void FMetricsLoggerEventMonitor::LogShaderEvent()
 {
 	shaderCompileInProgress = false;
 
-	CurrentShaderEvent.finishTime = FDateTime::UtcNow();
-	CurrentShaderEvent.duration = (CurrentShaderEvent.finishTime - CurrentShaderEvent.startTime).GetTotalSeconds();
+	CurrentShaderEvent.finishTime = FMetricsClock::Now();
+	CurrentShaderEvent.duration = FMetricsClock::ToSeconds(CurrentShaderEvent.finishTime - CurrentShaderEvent.startTime);
 	CurrentShaderEvent.success = true;
 
+	// Sessions during a cook are time the cook spends waiting on shaders
+	CurrentShaderEvent.parentSpanId = CookPhases.AddPhase(FCookPhaseTracker::EPhase::ShaderCompile, CurrentShaderEvent.startTime, CurrentShaderEvent.finishTime);
+
+	const double workerSeconds = CurrentShaderStats.sampledSeconds * ShaderWorkerCount;
+	CurrentShaderEvent.AddField("shader_jobs", CurrentShaderStats.totalJobs);
+	CurrentShaderEvent.AddField("shader_jobs_peak", CurrentShaderStats.peakRemainingJobs);
+	CurrentShaderEvent.AddField("shader_workers", ShaderWorkerCount);
+	CurrentShaderEvent.AddField("shader_worker_utilization", workerSeconds > 0.0 ? 100.0 * CurrentShaderStats.busyWorkerSeconds / workerSeconds : 0.0);
+	FMetricsDDCSnapshot::Capture().AddDelta(CurrentShaderDDCStart, CurrentShaderEvent);
+	ResourceSampler.EndSession(CurrentShaderResources, CurrentShaderEvent);
+
 	MetricsLogger.Log(CurrentShaderEvent);
+
+	ShaderHotspots.EndSession(CurrentShaderEvent, CurrentShaderStats.busyWorkerSeconds, GetDefault<UMetricsLoggerSettings>()->ShaderHotspotCount, MetricsLogger);
 }
 
 
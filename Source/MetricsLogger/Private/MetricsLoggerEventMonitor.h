@@ -23,6 +23,13 @@
 
 // Data Models
 #include "MetricsModel.h"
+#include "CookPhaseTracker.h"
+#include "EditorFrameRecorder.h"
+#include "EditorStartupTracker.h"
+#include "MetricsDDCSnapshot.h"
+#include "MetricsInFlightTable.h"
+#include "MetricsResourceSampler.h"
+#include "ShaderHotspotTracker.h"
 
 // Allow the monitor to be called every tick in the editor
 #include "TickableEditorObject.h"
@@ -37,6 +44,7 @@ class FMetricsLoggerEventMonitor: public FTickableEditorObject
 {
 public:
 	FMetricsLoggerEventMonitor(IMetricsLogger& logger);
+	~FMetricsLoggerEventMonitor();
 
 	void ProcessEvent(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson);
 	
@@ -48,7 +56,12 @@ public:
 	}
 	virtual ETickableTickType GetTickableTickType() const override
 	{
-		return ETickableTickType::Always;
+		return ETickableTickType::Conditional;
+	}
+	virtual bool IsTickable() const override
+	{
+		// Only tick while there is a compile to watch or an operation that may need expiring, or to time every frame
+		return shaderCompileInProgress || InFlightEvents.Num() > 0 || FrameRecorder.IsEnabled() || StartupTracker.IsPending();
 	}
 	virtual bool IsTickableInEditor() const
 	{
@@ -75,22 +88,58 @@ private:
 	void OnPackageFailed(const FString& EventName, const TArray<FAnalyticsEventAttribute>& Attrs, bool bJson);
 	void LogPackageEvent(const TArray<FAnalyticsEventAttribute>& Attrs, bool success);
 
+	// Operations tracked from a start to a stop or failure event, paired by event type and platform,
+	// with the cache and resource usage from when they started
+	struct InFlightEvent {
+		EventMetaData eventData;
+		FMetricsDDCSnapshot ddcStart;
+		FMetricsResourceSampler::FSession resources;
+	};
+	void StartEvent(LogEventTypeEnum type, const TArray<FAnalyticsEventAttribute>& Attrs);
+	void FinishEvent(LogEventTypeEnum type, const TArray<FAnalyticsEventAttribute>& Attrs, bool success);
+	void LogFinishedEvent(InFlightEvent& inFlight, int64 finishTime, bool success);
+	void ExpireEvents(int64 olderThan);
+
 	// Shader Compile Events
 	void OnShaderStart();
+	void SampleShaderJobs(float DeltaTime);
 	void LogShaderEvent();
 
 	// Logger for reporting event stats
 	IMetricsLogger& MetricsLogger;
 
-	// Metadata for tracking the current cook process
-	EventMetaData CurrentCookEvent;
-	bool cookInProgress { false };
+	// Cook and package operations that have started but not finished yet
+	TMetricsInFlightTable<InFlightEvent> InFlightEvents;
+	FCookPhaseTracker CookPhases;
+
+	// Samples CPU, memory and IO use while any cook, package or shader session is running
+	FMetricsResourceSampler ResourceSampler;
+
+	// Editor frame times and hitches, and how long the editor took to start
+	FEditorFrameRecorder FrameRecorder;
+	FEditorStartupTracker StartupTracker;
+
+	// Set when this process is the cook commandlet, which cooks from startup to shutdown without any analytics events
+	bool cookCommandlet{ false };
 
-	// Metadata for storing current package event
-	EventMetaData CurrentPackageEvent;
-	bool packageInProgress{ false };
+	// Binding to the global shader compile notification
+	FDelegateHandle ShaderCompileHandle;
 
 	// Flag for tracking shader compiling
-	bool shaderCompileInProgress;
+	bool shaderCompileInProgress{ false };
 	EventMetaData CurrentShaderEvent;
+	FMetricsDDCSnapshot CurrentShaderDDCStart;
+	FMetricsResourceSampler::FSession CurrentShaderResources;
+
+	// Job counts sampled from the shader compiling manager during a compile session
+	struct ShaderSessionStats {
+		int32 lastRemainingJobs{ 0 };
+		int32 totalJobs{ 0 };
+		int32 peakRemainingJobs{ 0 };
+		double busyWorkerSeconds{ 0.0 };
+		double sampledSeconds{ 0.0 };
+	};
+	ShaderSessionStats CurrentShaderStats;
+	int32 ShaderWorkerCount{ 1 };
+	FShaderHotspotTracker ShaderHotspots;
 };
@@ -28,14 +28,21 @@
 
 // Settings
 #include "MetricsLoggerSettings.h"
+#include "MetricsSettingsSnapshot.h"
 #include "ISettingsModule.h"
 #include "ISettingsSection.h"
 #include "ISettingsContainer.h"
 
 // Utilities
+#include "Misc/CommandLine.h"
 #include "Misc/DateTime.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
 
-#include "InfluxDBLogger.h"
+#include "FileSink.h"
+#include "InfluxDBSink.h"
+#include "UdpSink.h"
+#include "MetricsLoggerPipeline.h"
 
 #define LOCTEXT_NAMESPACE "FMetricsLoggerModule"
 
@@ -45,6 +52,7 @@ void FMetricsLoggerModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 	RegisterSettings();
+	FMetricsSettings::Update();
 	RegisterEventMonitor();
 }
 
@@ -59,8 +67,27 @@ void FMetricsLoggerModule::ShutdownModule()
 
 void FMetricsLoggerModule::RegisterEventMonitor()
 {
-	// If needed, could instantiate different loggers based on some settings option in future
-	MetricsLogger = MakeUnique<FInfluxDBLogger>();
+	// Every enabled sink gets the same batches from the pipeline
+	const UMetricsLoggerSettings* Settings = GetDefault<UMetricsLoggerSettings>();
+	TArray<TUniquePtr<IMetricsSink>> sinks;
+	if (Settings->EnableInfluxDBSink) {
+		sinks.Add(MakeUnique<FInfluxDBSink>());
+	}
+
+	// Build machines can ask for a file sink on the command line without touching the project settings
+	FString fileDirectory;
+	const bool bFileDirectoryOnCommandLine = FParse::Value(FCommandLine::Get(), TEXT("MetricsFileDir="), fileDirectory);
+	if (Settings->EnableFileSink || bFileDirectoryOnCommandLine) {
+		if (!bFileDirectoryOnCommandLine) {
+			fileDirectory = Settings->FileDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("MetricsLogger") / TEXT("Files") : Settings->FileDirectory;
+		}
+		sinks.Add(MakeUnique<FFileSink>(fileDirectory));
+	}
+
+	if (Settings->EnableUdpSink) {
+		sinks.Add(MakeUnique<FUdpSink>());
+	}
+	MetricsLogger = MakeUnique<FMetricsLoggerPipeline>(MoveTemp(sinks));
 
 	EventMonitor = MakeUnique<FMetricsLoggerEventMonitor>(*MetricsLogger.Get());
 
@@ -76,8 +103,13 @@ void FMetricsLoggerModule::RegisterEventMonitor()
 
 void FMetricsLoggerModule::UnRegisterEventMonitor()
 {
-	MetricsLogger.Reset();
 	EventMonitor.Reset();
+
+	// Write out anything still waiting in a batch before the logger goes away
+	if (MetricsLogger.IsValid()) {
+		MetricsLogger->Flush();
+	}
+	MetricsLogger.Reset();
 }
 
 void FMetricsLoggerModule::RegisterSettings()
@@ -123,6 +155,9 @@ bool FMetricsLoggerModule::SaveSettings()
 {
 	UMetricsLoggerSettings* Settings = GetMutableDefault<UMetricsLoggerSettings>();
 	Settings->SaveConfig();
+
+	// The logger threads pick the new values up from the next snapshot
+	FMetricsSettings::Update();
 	return true;
 }
 
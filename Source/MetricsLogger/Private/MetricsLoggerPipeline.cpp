@@ -0,0 +1,309 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsLoggerPipeline.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "MetricsClock.h"
+#include "MetricsSelfStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Number of events that can be waiting for the pipeline thread before new ones are dropped
+const uint32 EVENT_QUEUE_CAPACITY = 4096;
+
+// Longest the pipeline thread sleeps before checking the queue and the batch deadline
+const uint32 PIPELINE_WAIT_MS = 250;
+
+// User tag value when LogUser is disabled
+static const FString UNLOGGED_USER = TEXT("N/A");
+
+// Nanoseconds per unit of each precision
+static int64 GetTimestampUnit(TimestampPrecision precision)
+{
+	switch (precision)
+	{
+		case TimestampPrecision::Milliseconds:
+			return 1000000;
+		case TimestampPrecision::Microseconds:
+			return 1000;
+		case TimestampPrecision::Nanoseconds:
+			return 1;
+		default:
+			return 1000000000;
+	}
+}
+
+FMetricsLoggerPipeline::FMetricsLoggerPipeline(TArray<TUniquePtr<IMetricsSink>>&& InSinks)
+	: Sinks(MoveTemp(InSinks))
+	, EventQueue(EVENT_QUEUE_CAPACITY)
+{
+	StartThread();
+}
+
+FMetricsLoggerPipeline::FMetricsLoggerPipeline(TArray<TUniquePtr<IMetricsSink>>&& InSinks, const FMetricsSettingsRef& InSettings)
+	: Sinks(MoveTemp(InSinks))
+	, Settings(InSettings)
+	, EventQueue(EVENT_QUEUE_CAPACITY)
+{
+	StartThread();
+}
+
+void FMetricsLoggerPipeline::StartThread()
+{
+	NextSummaryTime = FPlatformTime::Seconds() + Settings->SummaryInterval;
+	NextCustomMetricTime = FPlatformTime::Seconds() + Settings->CustomMetricInterval;
+	NextSelfStatsTime = FPlatformTime::Seconds() + Settings->SelfTelemetryInterval;
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("MetricsLoggerPipeline"), 0, TPri_BelowNormal);
+}
+
+FMetricsLoggerPipeline::~FMetricsLoggerPipeline()
+{
+	// Stops the pipeline thread and waits for it to hand the last batch to the sinks
+	if (Thread) {
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	// Each sink writes out whatever it still has queued as it goes
+	Sinks.Empty();
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FMetricsLoggerPipeline::Log(const EventMetaData& data)
+{
+	// Everything else happens on the pipeline thread
+	if (EventQueue.Enqueue(data)) {
+		FMetricsSelfStats::Add(FMetricsSelfStats::Get().EventsLogged);
+	}
+	else {
+		DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+		FMetricsSelfStats::Add(FMetricsSelfStats::Get().EventsDropped);
+	}
+}
+
+void FMetricsLoggerPipeline::Flush()
+{
+	bFlushRequested = true;
+	WakeEvent->Trigger();
+}
+
+uint32 FMetricsLoggerPipeline::Run()
+{
+	while (!bStopping) {
+		WakeEvent->Wait(PIPELINE_WAIT_MS);
+
+		ProcessQueue();
+
+		if (FPlatformTime::Seconds() >= NextSummaryTime) {
+			Summarize();
+		}
+
+		// Threads aggregate their own metrics, so they only need draining once per interval
+		if (FPlatformTime::Seconds() >= NextCustomMetricTime) {
+			DrainCustomMetrics();
+			SummarizeCustomMetrics();
+		}
+
+		if (FPlatformTime::Seconds() >= NextSelfStatsTime) {
+			ReportSelfStats();
+		}
+
+		if (bFlushRequested.exchange(false)) {
+			FlushPending();
+			for (TUniquePtr<IMetricsSink>& sink : Sinks) {
+				sink->Flush();
+			}
+		}
+		else if (PendingBatch.IsValid() && FPlatformTime::Seconds() >= PendingDeadline) {
+			FlushPending();
+		}
+	}
+
+	// Hand over everything still queued before the thread exits
+	ProcessQueue();
+	Summarize();
+	DrainCustomMetrics();
+	SummarizeCustomMetrics();
+	ReportSelfStats();
+	FlushPending();
+
+	return 0;
+}
+
+void FMetricsLoggerPipeline::Stop()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+}
+
+void FMetricsLoggerPipeline::ProcessQueue()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(MetricsLoggerPipeline_ProcessQueue);
+
+	const uint32 dropped = DroppedEvents.exchange(0, std::memory_order_relaxed);
+	if (dropped > 0) {
+		UE_LOG(MetricsLog, Warning, TEXT("Metrics queue was full - dropped %u events."), dropped);
+	}
+
+	// Get settings
+	const FMetricsSettingsRef settings = Settings.Get();
+
+	// A batch is serialized with a single precision, so points with a different one start a new batch
+	if (settings->Precision != PendingPrecision) {
+		FlushPending();
+		PendingPrecision = settings->Precision;
+	}
+	const int64 timestampUnit = GetTimestampUnit(PendingPrecision);
+
+	EventMetaData data;
+	while (EventQueue.Dequeue(data)) {
+		if (!settings->EnableLogging) continue;
+
+		if (settings->EnableSummaries) {
+			Summaries.Record(data);
+		}
+		AddToBatch(data, timestampUnit);
+	}
+}
+
+void FMetricsLoggerPipeline::Summarize()
+{
+	NextSummaryTime = FPlatformTime::Seconds() + Settings->SummaryInterval;
+
+	TArray<EventMetaData> summaries;
+	Summaries.Summarize(FMetricsClock::Now(), summaries);
+
+	// Precision was brought up to date by the ProcessQueue call just before
+	for (const EventMetaData& summary : summaries) {
+		AddToBatch(summary, GetTimestampUnit(PendingPrecision));
+	}
+}
+
+void FMetricsLoggerPipeline::DrainCustomMetrics()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(MetricsLoggerPipeline_DrainCustomMetrics);
+
+	FMetricsRecorderRegistry::Drain([this](uint32 metricId, const FMetricsThreadValue& value) {
+		CustomMetrics.Merge(metricId, value);
+		});
+}
+
+void FMetricsLoggerPipeline::SummarizeCustomMetrics()
+{
+	const FMetricsSettingsRef settings = Settings.Get();
+	NextCustomMetricTime = FPlatformTime::Seconds() + settings->CustomMetricInterval;
+
+	TArray<EventMetaData> points;
+	CustomMetrics.Summarize(FMetricsClock::Now(), points);
+	if (!settings->EnableLogging) return;
+
+	// Precision was brought up to date by the ProcessQueue call just before
+	for (const EventMetaData& point : points) {
+		AddToBatch(point, GetTimestampUnit(PendingPrecision));
+	}
+}
+
+void FMetricsLoggerPipeline::ReportSelfStats()
+{
+	const FMetricsSettingsRef settings = Settings.Get();
+	NextSelfStatsTime = FPlatformTime::Seconds() + settings->SelfTelemetryInterval;
+	if (!settings->EnableLogging || !settings->EnableSelfTelemetry) return;
+
+	EventMetaData stats;
+	FMetricsSelfStats::Get().Report(FMetricsClock::Now(), EventQueue.Num(), stats);
+
+	// Precision was brought up to date by the ProcessQueue call just before
+	AddToBatch(stats, GetTimestampUnit(PendingPrecision));
+}
+
+void FMetricsLoggerPipeline::AddToBatch(const EventMetaData& data, int64 timestampUnit)
+{
+	const FMetricsSettingsRef settings = Settings.Get();
+
+	// The user tag is baked into the serializer's prefixes, so they are rebuilt if the setting changed.
+	// This is also where the machine metadata is first needed, so nothing waits for it until there is a point to write.
+	if (!Writer.IsInitialized() || WriterLogsUser != settings->LogUser) {
+		FlushPending();
+		InitializeWriter(settings->LogUser);
+	}
+
+	// Start the latency deadline from the first point of the batch
+	if (!PendingBatch.IsValid()) {
+		PendingBatch = MakeShared<FMetricsBatch, ESPMode::ThreadSafe>();
+		PendingBatch->Precision = PendingPrecision;
+		PendingBatch->Tags = Tags;
+		PendingBatch->Events.Reserve(settings->BatchMaxPoints);
+		PendingBatch->LineProtocol.Reserve(settings->BatchMaxBytes);
+		PendingDeadline = FPlatformTime::Seconds() + settings->BatchMaxLatency;
+	}
+
+	// Format metadata
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	const int32 startBytes = PendingBatch->LineProtocol.Num();
+	Writer.Write(data, timestampUnit, PendingBatch->LineProtocol);
+	PendingBatch->Events.Add(data);
+
+	FMetricsSelfStats& selfStats = FMetricsSelfStats::Get();
+	FMetricsSelfStats::Add(selfStats.SerializeCycles, FPlatformTime::Cycles64() - startCycles);
+	FMetricsSelfStats::Add(selfStats.BytesSerialized, (uint64)(PendingBatch->LineProtocol.Num() - startBytes));
+
+	if (PendingBatch->Events.Num() >= settings->BatchMaxPoints || PendingBatch->LineProtocol.Num() >= settings->BatchMaxBytes) {
+		FlushPending();
+	}
+}
+
+void FMetricsLoggerPipeline::InitializeWriter(bool logUser)
+{
+	const FMetricsMachineInfo& machine = GetMachineInfo();
+	const FString& user = logUser ? machine.Username : UNLOGGED_USER;
+	WriterLogsUser = logUser;
+
+	TArray<FLineProtocolWriter::FTag> tags;
+	tags.Emplace(TEXT("project_name"), ProjectName);
+	tags.Emplace(TEXT("cpu_model"), machine.CpuModel);
+	tags.Emplace(TEXT("cpu_core_count"), machine.CoreCount);
+	tags.Emplace(TEXT("gpu_model"), machine.GpuModel);
+	tags.Emplace(TEXT("ram_size"), machine.RamSize);
+	tags.Emplace(TEXT("machine_name"), machine.MachineName);
+	tags.Emplace(TEXT("unreal_version"), UnrealVersion);
+	tags.Emplace(TEXT("extension_version"), ExtensionVersion);
+
+	Writer.Initialize(tags, user);
+
+	// Batches already handed out keep the tags they were serialized with
+	TSharedRef<FMetricsTags, ESPMode::ThreadSafe> batchTags = MakeShared<FMetricsTags, ESPMode::ThreadSafe>(tags);
+	batchTags->Emplace(TEXT("user"), user);
+	Tags = batchTags;
+}
+
+void FMetricsLoggerPipeline::FlushPending()
+{
+	if (!PendingBatch.IsValid()) return;
+
+	// The batch is never modified again, so every sink can share it
+	const FMetricsBatchRef batch = PendingBatch.ToSharedRef();
+	PendingBatch.Reset();
+	FMetricsSelfStats::Add(FMetricsSelfStats::Get().Batches);
+
+	for (TUniquePtr<IMetricsSink>& sink : Sinks) {
+		sink->Submit(batch);
+	}
+}
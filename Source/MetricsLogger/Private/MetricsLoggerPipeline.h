@@ -0,0 +1,100 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+// Parent Class
+#include "IMetricsLogger.h"
+#include "IMetricsSink.h"
+#include "LineProtocolWriter.h"
+#include "MetricsCustomAggregator.h"
+#include "MetricsEventQueue.h"
+#include "MetricsSettingsSnapshot.h"
+#include "MetricsSummaryAggregator.h"
+
+#include <atomic>
+
+/**
+ * MetricsLogger that fans events out to any number of sinks.
+ *
+ * Log only copies the event into a lock-free queue. A dedicated thread drains the queue, serializes the events once
+ * into a batch and hands the same immutable batch to every sink, each of which writes it out on its own thread.
+ */
+class FMetricsLoggerPipeline: public IMetricsLogger, public FRunnable
+{
+public:
+	FMetricsLoggerPipeline(TArray<TUniquePtr<IMetricsSink>>&& InSinks);
+
+	// Uses the given settings instead of following the project settings
+	FMetricsLoggerPipeline(TArray<TUniquePtr<IMetricsSink>>&& InSinks, const FMetricsSettingsRef& InSettings);
+	virtual ~FMetricsLoggerPipeline();
+
+	void Log(const EventMetaData& data) override;
+	void Flush() override;
+
+	// FRunnable overrides
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	void StartThread();
+	void ProcessQueue();
+	void Summarize();
+	void DrainCustomMetrics();
+	void SummarizeCustomMetrics();
+	void ReportSelfStats();
+	void AddToBatch(const EventMetaData& data, int64 timestampUnit);
+	void FlushPending();
+	void InitializeWriter(bool logUser);
+
+	// Destinations of every batch
+	TArray<TUniquePtr<IMetricsSink>> Sinks;
+
+	// Settings for the pipeline thread - picked up again whenever they change
+	FMetricsSettingsCache Settings;
+
+	// Serializer with the metadata tags pre-encoded - only touched by the pipeline thread
+	FLineProtocolWriter Writer;
+	TSharedPtr<const FMetricsTags, ESPMode::ThreadSafe> Tags;
+	bool WriterLogsUser{ false };
+
+	// Events handed over from the logging threads
+	TMetricsEventQueue<EventMetaData> EventQueue;
+	std::atomic<uint32> DroppedEvents{ 0 };
+
+	// Pipeline thread and the event used to wake it early
+	FRunnableThread* Thread{ nullptr };
+	FEvent* WakeEvent{ nullptr };
+	std::atomic<bool> bStopping{ false };
+	std::atomic<bool> bFlushRequested{ false };
+
+	// Batch being filled - only touched by the pipeline thread
+	TSharedPtr<FMetricsBatch, ESPMode::ThreadSafe> PendingBatch;
+	TimestampPrecision PendingPrecision{ TimestampPrecision::Seconds };
+	double PendingDeadline{ 0.0 };
+
+	// Duration histograms logged as summary points every SummaryInterval
+	FMetricsSummaryAggregator Summaries;
+	double NextSummaryTime{ 0.0 };
+
+	// Metrics recorded through FMetricsRecorder, drained and logged every CustomMetricInterval
+	FMetricsCustomAggregator CustomMetrics;
+	double NextCustomMetricTime{ 0.0 };
+
+	// The logger's own stats are logged every SelfTelemetryInterval
+	double NextSelfStatsTime{ 0.0 };
+};
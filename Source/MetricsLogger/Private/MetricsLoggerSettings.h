@@ -24,6 +24,34 @@ enum class InfluxDBVersion {
 	V2 UMETA(DisplayName = "v2.0")
 };
 
+UENUM()
+enum class TimestampPrecision {
+	Seconds UMETA(DisplayName = "Seconds"),
+	Milliseconds UMETA(DisplayName = "Milliseconds"),
+	Microseconds UMETA(DisplayName = "Microseconds"),
+	Nanoseconds UMETA(DisplayName = "Nanoseconds")
+};
+const int32 NUM_TIMESTAMP_PRECISIONS = 4;
+
+UENUM()
+enum class SinkBackpressure {
+	DropNewest UMETA(DisplayName = "Drop Newest"),
+	DropOldest UMETA(DisplayName = "Drop Oldest")
+};
+
+UENUM()
+enum class FileSinkFormat {
+	LineProtocol UMETA(DisplayName = "Line Protocol"),
+	JsonLines UMETA(DisplayName = "JSON Lines"),
+	Binary UMETA(DisplayName = "Binary")
+};
+
+UENUM()
+enum class UdpSinkFormat {
+	StatsD UMETA(DisplayName = "StatsD"),
+	LineProtocol UMETA(DisplayName = "InfluxDB Line Protocol")
+};
+
 /**
  * Class for defining a settings page in the Editor preferences window.
  */
@@ -46,6 +74,10 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = LoggingConfig)
 	FString InfluxURL;
 
+	// Precision of the timestamps written to InfluxDB - finer precision keeps points from parallel events apart
+	UPROPERTY(config, EditAnywhere, Category = LoggingConfig)
+	TimestampPrecision Precision = TimestampPrecision::Seconds;
+
 	// InfluxDB V1 Config - Only visible if InfluxDBVerion is equal to InfluxDBVersion::V1
 	UPROPERTY(config, EditAnywhere, Category = LoggingConfig, meta = (EditCondition = "InfluxVersion == InfluxDBVersion::V1", EditConditionHides))
 	FString InfluxUser;
@@ -65,4 +97,169 @@ public:
 
 	UPROPERTY(config, EditAnywhere, Category = LoggingConfig, meta = (EditCondition = "InfluxVersion == InfluxDBVersion::V2", EditConditionHides))
 	FString InfluxBucket;
+
+	// Batching - points are buffered and written in a single request once any of these thresholds is reached
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "1"))
+	int32 BatchMaxPoints = 100;
+
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "1024", Units = "Bytes"))
+	int32 BatchMaxBytes = 256 * 1024;
+
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "0.0", Units = "s"))
+	float BatchMaxLatency = 10.0f;
+
+	// Compression - batches at least this large are sent gzip encoded
+	UPROPERTY(config, EditAnywhere, Category = Batching)
+	bool CompressRequests = true;
+
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "0", Units = "Bytes", EditCondition = "CompressRequests"))
+	int32 CompressionMinBytes = 1024;
+
+	// Summaries - durations are also kept in histograms per event type and success and logged as summary_event points
+	// with their count and percentiles once per interval
+	UPROPERTY(config, EditAnywhere, Category = Batching)
+	bool EnableSummaries = true;
+
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "1.0", Units = "s", EditCondition = "EnableSummaries"))
+	float SummaryInterval = 300.0f;
+
+	// Custom metrics - timers, counters and gauges recorded through the METRICS_ macros are logged as custom_metric points
+	// once per interval
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "1.0", Units = "s"))
+	float CustomMetricInterval = 60.0f;
+
+	// Self telemetry - the logger's own overhead and health are logged as a metricslogger_internal point once per interval
+	UPROPERTY(config, EditAnywhere, Category = Batching)
+	bool EnableSelfTelemetry = true;
+
+	UPROPERTY(config, EditAnywhere, Category = Batching, meta = (ClampMin = "1.0", Units = "s", EditCondition = "EnableSelfTelemetry"))
+	float SelfTelemetryInterval = 300.0f;
+
+	// Sinks - every batch is written to each enabled sink, and each sink queues up to SinkQueueCapacity batches
+	UPROPERTY(config, EditAnywhere, Category = Sinks, meta = (ClampMin = "1"))
+	int32 SinkQueueCapacity = 64;
+
+	UPROPERTY(config, EditAnywhere, Category = Sinks)
+	bool EnableInfluxDBSink = true;
+
+	// What to drop once the InfluxDB sink's queue is full
+	UPROPERTY(config, EditAnywhere, Category = Sinks, meta = (EditCondition = "EnableInfluxDBSink"))
+	SinkBackpressure InfluxBackpressure = SinkBackpressure::DropOldest;
+
+	// Most requests to InfluxDB in flight at once - further batches wait in the sink's queue until one completes
+	UPROPERTY(config, EditAnywhere, Category = Sinks, meta = (ClampMin = "1", EditCondition = "EnableInfluxDBSink"))
+	int32 InfluxMaxInFlightRequests = 4;
+
+	UPROPERTY(config, EditAnywhere, Category = Sinks, meta = (ClampMin = "1.0", Units = "s", EditCondition = "EnableInfluxDBSink"))
+	float InfluxRequestTimeout = 30.0f;
+
+	// File sink - batches are appended to rotating files that can be archived and imported later.
+	// Passing -MetricsFileDir=<path> on the command line enables it for that run regardless of this setting.
+	UPROPERTY(config, EditAnywhere, Category = FileSink)
+	bool EnableFileSink = false;
+
+	// Defaults to Saved/MetricsLogger/Files in the project when empty
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (EditCondition = "EnableFileSink"))
+	FString FileDirectory;
+
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (EditCondition = "EnableFileSink"))
+	FileSinkFormat FileFormat = FileSinkFormat::LineProtocol;
+
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (ClampMin = "1", Units = "Megabytes", EditCondition = "EnableFileSink"))
+	int32 FileSegmentMaxSizeMB = 64;
+
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (ClampMin = "1.0", Units = "s", EditCondition = "EnableFileSink"))
+	float FileSegmentMaxAge = 3600.0f;
+
+	// Longest written data can stay in the OS file cache before it is synced to disk
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (ClampMin = "0.0", Units = "s", EditCondition = "EnableFileSink"))
+	float FileSyncInterval = 5.0f;
+
+	UPROPERTY(config, EditAnywhere, Category = FileSink, meta = (EditCondition = "EnableFileSink"))
+	SinkBackpressure FileBackpressure = SinkBackpressure::DropOldest;
+
+	// UDP sink - events are aggregated per type and success over each interval and sent to a StatsD or InfluxDB UDP listener
+	UPROPERTY(config, EditAnywhere, Category = UdpSink)
+	bool EnableUdpSink = false;
+
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (EditCondition = "EnableUdpSink"))
+	UdpSinkFormat UdpFormat = UdpSinkFormat::StatsD;
+
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (EditCondition = "EnableUdpSink"))
+	FString UdpHost = TEXT("127.0.0.1");
+
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (ClampMin = "1", ClampMax = "65535", EditCondition = "EnableUdpSink"))
+	int32 UdpPort = 8125;
+
+	// Metric name prefix for StatsD, measurement prefix for line protocol
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (EditCondition = "EnableUdpSink"))
+	FString UdpPrefix = TEXT("unreal");
+
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (ClampMin = "0.1", Units = "s", EditCondition = "EnableUdpSink"))
+	float UdpFlushInterval = 10.0f;
+
+	// Keep below the path MTU minus the IP and UDP headers so datagrams aren't fragmented
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (ClampMin = "512", ClampMax = "65507", Units = "Bytes", EditCondition = "EnableUdpSink"))
+	int32 UdpMaxDatagramBytes = 1432;
+
+	UPROPERTY(config, EditAnywhere, Category = UdpSink, meta = (EditCondition = "EnableUdpSink"))
+	SinkBackpressure UdpBackpressure = SinkBackpressure::DropOldest;
+
+	// Shaders - number of materials with the most compiled permutations to report after each shader compile session
+	UPROPERTY(config, EditAnywhere, Category = Shaders, meta = (ClampMin = "0"))
+	int32 ShaderHotspotCount = 10;
+
+	// Frames - editor frame times are kept in a histogram and logged with the longest hitches once per interval
+	UPROPERTY(config, EditAnywhere, Category = Frames)
+	bool EnableFrameCapture = true;
+
+	UPROPERTY(config, EditAnywhere, Category = Frames, meta = (ClampMin = "0.0", Units = "s", EditCondition = "EnableFrameCapture"))
+	float HitchThreshold = 0.1f;
+
+	UPROPERTY(config, EditAnywhere, Category = Frames, meta = (ClampMin = "0", EditCondition = "EnableFrameCapture"))
+	int32 MaxHitchesPerInterval = 20;
+
+	UPROPERTY(config, EditAnywhere, Category = Frames, meta = (ClampMin = "1.0", Units = "s", EditCondition = "EnableFrameCapture"))
+	float FrameSummaryInterval = 300.0f;
+
+	// Startup - an editor launch is logged as a startup_event with its phases once the first frame is ticked
+	UPROPERTY(config, EditAnywhere, Category = Startup)
+	bool EnableStartupTiming = true;
+
+	// Phases - package saves and garbage collections during a cook that take at least this long are logged as their own spans
+	UPROPERTY(config, EditAnywhere, Category = Phases, meta = (ClampMin = "0.0", Units = "s"))
+	float PhaseSpanMinDuration = 1.0f;
+
+	// Cooks and packages that haven't finished after this long are logged as aborted
+	UPROPERTY(config, EditAnywhere, Category = Phases, meta = (ClampMin = "1.0", Units = "Minutes"))
+	float EventTimeout = 240.0f;
+
+	// Cook, package and shader events include how much the Derived Data Cache was used during them
+	UPROPERTY(config, EditAnywhere, Category = Phases)
+	bool EnableDDCStats = true;
+
+	// Resources - CPU, memory and IO use are sampled at this rate while a cook, package or shader session is running
+	UPROPERTY(config, EditAnywhere, Category = Resources)
+	bool EnableResourceSampling = true;
+
+	UPROPERTY(config, EditAnywhere, Category = Resources, meta = (ClampMin = "0.1", Units = "s", EditCondition = "EnableResourceSampling"))
+	float ResourceSampleInterval = 1.0f;
+
+	// Retry - delays between attempts to resend a batch grow at random between the minimum and maximum, and after
+	// CircuitBreakerThreshold failures in a row nothing is sent until CircuitBreakerOpenDuration has passed
+	UPROPERTY(config, EditAnywhere, Category = Retry, meta = (ClampMin = "0.1", Units = "s"))
+	float RetryMinDelay = 5.0f;
+
+	UPROPERTY(config, EditAnywhere, Category = Retry, meta = (ClampMin = "0.1", Units = "s"))
+	float RetryMaxDelay = 300.0f;
+
+	UPROPERTY(config, EditAnywhere, Category = Retry, meta = (ClampMin = "1"))
+	int32 CircuitBreakerThreshold = 5;
+
+	UPROPERTY(config, EditAnywhere, Category = Retry, meta = (ClampMin = "0.0", Units = "s"))
+	float CircuitBreakerOpenDuration = 600.0f;
+
+	// Spool - batches that could not be sent are kept in the project's Saved directory and replayed later
+	UPROPERTY(config, EditAnywhere, Category = Spool, meta = (ClampMin = "1", Units = "Megabytes"))
+	int32 SpoolMaxSizeMB = 64;
 };
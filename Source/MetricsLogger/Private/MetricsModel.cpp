@@ -0,0 +1,48 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsModel.h"
+#include "CoreMinimal.h"
+
+void EventMetaData::AddTag(const ANSICHAR* key, const TCHAR* value)
+{
+	FTCHARToUTF8 utf8(value);
+	AddTagUtf8(key, utf8.Get(), utf8.Length());
+}
+
+void EventMetaData::AddTagUtf8(const ANSICHAR* key, const ANSICHAR* value, int32 valueLength)
+{
+	if (numTags >= MAX_EVENT_TAGS) return;
+
+	int32 length = FMath::Min(valueLength, MAX_EVENT_TAG_BYTES - tagValuesSize);
+
+	// Don't cut a multi-byte character in half
+	if (length < valueLength) {
+		while (length > 0 && (value[length] & 0xC0) == 0x80) {
+			length--;
+		}
+	}
+
+	FMemory::Memcpy(tagValues + tagValuesSize, value, length);
+	tags[numTags++] = { key, tagValuesSize, length };
+	tagValuesSize += length;
+}
+
+uint64 MetricsLoggerUtils::NewSpanId()
+{
+	// Ids are written as signed integer fields, so keep them positive
+	const FGuid guid = FGuid::NewGuid();
+	return (((uint64)guid.A << 32) | guid.B) & MAX_int64;
+}
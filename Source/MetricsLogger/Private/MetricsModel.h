@@ -22,22 +22,75 @@ enum class LogEventTypeEnum {
 	BUILD,
 	COOK,
 	PACKAGE,
-	SHADER
+	SHADER,
+	SHADER_HOTSPOT,
+	PHASE,
+	SUMMARY,
+	INTERNAL,
+	CUSTOM,
+	HITCH,
+	STARTUP,
+
+	// Number of event types - keep last
+	NUM
+};
+
+// Additional numeric field reported with an event
+// Names must be string literals with no characters that need escaping, as events are copied between threads
+struct EventField {
+	const ANSICHAR* name;
+	double value;
 };
 
+// Additional tag reported with an event - the value is stored as UTF-8 in the event's tag buffer
+struct EventTag {
+	const ANSICHAR* key;
+	int32 valueOffset;
+	int32 valueLength;
+};
+
+// Maximum number of additional fields and tags an event can carry
+const int32 MAX_EVENT_FIELDS = 24;
+const int32 MAX_EVENT_TAGS = 4;
+const int32 MAX_EVENT_TAG_BYTES = 256;
+
 // Struct for storing metadata about an event
 struct EventMetaData {
-	LogEventTypeEnum type;
-	FDateTime startTime;
-	FDateTime finishTime;
+	LogEventTypeEnum type{ LogEventTypeEnum::UKNOWN };
+	// UTC times in nanoseconds since the Unix epoch, from FMetricsClock
+	int64 startTime{ 0 };
+	int64 finishTime{ 0 };
+	// Duration in seconds
 	double duration{ 0.0 };
 	bool success{ false };
+
+	// Span the event covers - nested events point at their parent's span so they can be rebuilt into a timeline
+	uint64 spanId{ 0 };
+	uint64 parentSpanId{ 0 };
+
+	EventField fields[MAX_EVENT_FIELDS];
+	int32 numFields{ 0 };
+
+	EventTag tags[MAX_EVENT_TAGS];
+	int32 numTags{ 0 };
+	ANSICHAR tagValues[MAX_EVENT_TAG_BYTES];
+	int32 tagValuesSize{ 0 };
+
+	void AddField(const ANSICHAR* name, double value) {
+		if (numFields < MAX_EVENT_FIELDS) {
+			fields[numFields++] = { name, value };
+		}
+	}
+
+	// Values that don't fit in the remaining tag buffer are truncated
+	void AddTag(const ANSICHAR* key, const TCHAR* value);
+	void AddTagUtf8(const ANSICHAR* key, const ANSICHAR* value, int32 valueLength);
 };
 
 namespace MetricsLoggerUtils {
 
 	// Converts an event enum to a string value
-	const TCHAR* LogEventTypeToFString(const LogEventTypeEnum type) {
+	inline const TCHAR* LogEventTypeToFString(const LogEventTypeEnum type) {
 		switch (type) 
 		{
 			case LogEventTypeEnum::BUILD:
@@ -52,8 +105,37 @@ namespace MetricsLoggerUtils {
 			case LogEventTypeEnum::SHADER:
 				return TEXT("shader_event");
 				break;
+			case LogEventTypeEnum::SHADER_HOTSPOT:
+				return TEXT("shader_hotspot_event");
+				break;
+			case LogEventTypeEnum::PHASE:
+				return TEXT("phase_event");
+				break;
+			case LogEventTypeEnum::SUMMARY:
+				return TEXT("summary_event");
+				break;
+			case LogEventTypeEnum::INTERNAL:
+				return TEXT("metricslogger_internal");
+				break;
+			case LogEventTypeEnum::CUSTOM:
+				return TEXT("custom_metric");
+				break;
+			case LogEventTypeEnum::HITCH:
+				return TEXT("hitch_event");
+				break;
+			case LogEventTypeEnum::STARTUP:
+				return TEXT("startup_event");
+				break;
 			default:
 				return TEXT("uknown_event");
 		}
 	};
+
+	// Whether the pipeline produced the event by aggregating others, so it shouldn't be aggregated again
+	inline bool IsAggregateEvent(const LogEventTypeEnum type) {
+		return type == LogEventTypeEnum::SUMMARY || type == LogEventTypeEnum::INTERNAL || type == LogEventTypeEnum::CUSTOM;
+	}
+
+	// Creates a new random span id
+	uint64 NewSpanId();
 }
\ No newline at end of file
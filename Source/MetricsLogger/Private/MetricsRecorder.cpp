@@ -0,0 +1,189 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsRecorder.h"
+#include "Misc/ScopeLock.h"
+
+static FCriticalSection& GetRegistryLock()
+{
+	static FCriticalSection Lock;
+	return Lock;
+}
+
+static TArray<TUniquePtr<FMetricsThreadBuffer>>& GetRegisteredBuffers()
+{
+	static TArray<TUniquePtr<FMetricsThreadBuffer>> Buffers;
+	return Buffers;
+}
+
+struct FMetricKey
+{
+	FName Name;
+	EMetricKind Kind;
+
+	bool operator==(const FMetricKey& Other) const
+	{
+		return Name == Other.Name && Kind == Other.Kind;
+	}
+
+	friend uint32 GetTypeHash(const FMetricKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.Name), (uint32)Key.Kind);
+	}
+};
+
+struct FRegisteredMetric
+{
+	FMetricKey Key;
+	// Sites currently registering the metric
+	int32 NumSites{ 0 };
+};
+
+// Metrics are indexed by id. They are registered from static initializers in other modules, so they get a lock of their own.
+struct FMetricsTable
+{
+	FCriticalSection Lock;
+	TArray<FRegisteredMetric> Metrics;
+	TMap<FMetricKey, uint32> Ids;
+};
+
+static FMetricsTable& GetMetricsTable()
+{
+	static FMetricsTable Table;
+	return Table;
+}
+
+uint32 FMetricsRecorderRegistry::RegisterMetric(const ANSICHAR* Name, EMetricKind Kind)
+{
+	const FMetricKey key{ FName(Name), Kind };
+
+	FMetricsTable& table = GetMetricsTable();
+	FScopeLock ScopeLock(&table.Lock);
+
+	uint32 id;
+	if (const uint32* existing = table.Ids.Find(key)) {
+		id = *existing;
+	}
+	else {
+		id = table.Metrics.Num();
+		table.Metrics.AddDefaulted_GetRef().Key = key;
+		table.Ids.Add(key, id);
+	}
+
+	table.Metrics[id].NumSites++;
+	return id;
+}
+
+void FMetricsRecorderRegistry::UnregisterMetric(uint32 Id)
+{
+	FMetricsTable& table = GetMetricsTable();
+	FScopeLock ScopeLock(&table.Lock);
+
+	if (table.Metrics.IsValidIndex(Id) && table.Metrics[Id].NumSites > 0) {
+		table.Metrics[Id].NumSites--;
+	}
+}
+
+bool FMetricsRecorderRegistry::GetMetric(uint32 Id, FName& OutName, EMetricKind& OutKind)
+{
+	FMetricsTable& table = GetMetricsTable();
+	FScopeLock ScopeLock(&table.Lock);
+
+	if (!table.Metrics.IsValidIndex(Id)) return false;
+
+	const FRegisteredMetric& metric = table.Metrics[Id];
+	OutName = metric.Key.Name;
+	OutKind = metric.Key.Kind;
+	return metric.NumSites > 0;
+}
+
+// Flags the thread's buffer when the thread exits - the buffer itself belongs to the registry
+struct FMetricsThreadBufferHandle
+{
+	FMetricsThreadBuffer* Buffer{ nullptr };
+
+	~FMetricsThreadBufferHandle()
+	{
+		if (Buffer) {
+			Buffer->bThreadExited.store(true, std::memory_order_release);
+		}
+	}
+};
+
+static thread_local FMetricsThreadBufferHandle ThreadBufferHandle;
+
+FMetricsThreadBuffer& FMetricsRecorderRegistry::GetThreadBuffer()
+{
+	if (!ThreadBufferHandle.Buffer) {
+		TUniquePtr<FMetricsThreadBuffer> buffer = MakeUnique<FMetricsThreadBuffer>();
+		ThreadBufferHandle.Buffer = buffer.Get();
+
+		FScopeLock ScopeLock(&GetRegistryLock());
+		GetRegisteredBuffers().Add(MoveTemp(buffer));
+	}
+	return *ThreadBufferHandle.Buffer;
+}
+
+void FMetricsRecorderRegistry::Drain(TFunctionRef<void(uint32 MetricId, const FMetricsThreadValue& Value)> Callback)
+{
+	FScopeLock ScopeLock(&GetRegistryLock());
+
+	TArray<TUniquePtr<FMetricsThreadBuffer>>& buffers = GetRegisteredBuffers();
+	for (int32 i = buffers.Num() - 1; i >= 0; i--) {
+		FMetricsThreadBuffer& buffer = *buffers[i];
+
+		// Checked before draining so nothing the thread recorded before exiting is missed
+		const bool bExited = buffer.bThreadExited.load(std::memory_order_acquire);
+		buffer.Drain(Callback);
+
+		if (bExited) {
+			buffers.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
+
+void FMetricsRecorder::RecordTime(const FMetricDescriptor& Descriptor, uint64 Cycles)
+{
+	FMetricsRecorderRegistry::GetThreadBuffer().Update(Descriptor.Id, [Cycles](FMetricsThreadValue& value) {
+		value.Durations.Record(FPlatformTime::ToSeconds64(Cycles));
+		});
+}
+
+void FMetricsRecorder::RecordValue(const FMetricDescriptor& Descriptor, double Value)
+{
+	FMetricsThreadBuffer& buffer = FMetricsRecorderRegistry::GetThreadBuffer();
+	if (Descriptor.Kind == EMetricKind::Gauge) {
+		const uint64 cycles = FPlatformTime::Cycles64();
+		buffer.Update(Descriptor.Id, [Value, cycles](FMetricsThreadValue& value) {
+			value.Value = Value;
+			value.SetCycles = cycles;
+			});
+	}
+	else {
+		buffer.Update(Descriptor.Id, [Value](FMetricsThreadValue& value) {
+			value.Value += Value;
+			});
+	}
+}
+
+uint32 FMetricsRecorder::RegisterMetric(const ANSICHAR* Name, EMetricKind Kind)
+{
+	return FMetricsRecorderRegistry::RegisterMetric(Name, Kind);
+}
+
+void FMetricsRecorder::UnregisterMetric(uint32 Id)
+{
+	FMetricsRecorderRegistry::UnregisterMetric(Id);
+}
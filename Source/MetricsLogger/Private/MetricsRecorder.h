@@ -0,0 +1,129 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+
+#include "MetricsHistogram.h"
+#include "MetricsLoggerModule.h"
+
+#include <atomic>
+
+// What one thread recorded for a metric since the last drain
+struct FMetricsThreadValue
+{
+	// Timers
+	FMetricsHistogram Durations;
+	// Counters add up, gauges keep the latest value along with when it was set, to pick the latest across threads
+	double Value{ 0.0 };
+	uint64 SetCycles{ 0 };
+	bool bUpdated{ false };
+};
+
+/**
+ * Pre-aggregates the metrics recorded by one thread, so recording never has to drop anything however fast it goes.
+ *
+ * There are two sets of values. The owning thread updates the active one while the draining thread swaps them and
+ * reads the other - a handshake on the active index and a busy flag per set makes sure the drain never reads a set
+ * the owning thread is still updating, without the owning thread ever waiting.
+ */
+class FMetricsThreadBuffer
+{
+public:
+	// Owning thread only. Apply is called with the metric's value for the current interval.
+	template<typename ApplyType>
+	void Update(uint32 MetricId, ApplyType&& Apply)
+	{
+		// Either the drain sees the set busy and waits, or the set is found to be swapped out and the other one is used
+		uint32 active;
+		for (;;) {
+			active = Active.load(std::memory_order_seq_cst);
+			Sets[active].bBusy.store(true, std::memory_order_seq_cst);
+			if (Active.load(std::memory_order_seq_cst) == active) break;
+			Sets[active].bBusy.store(false, std::memory_order_release);
+		}
+
+		TArray<FMetricsThreadValue>& values = Sets[active].Values;
+		if ((int32)MetricId >= values.Num()) {
+			values.SetNum(MetricId + 1);
+		}
+		FMetricsThreadValue& value = values[MetricId];
+		Apply(value);
+		value.bUpdated = true;
+
+		Sets[active].bBusy.store(false, std::memory_order_release);
+	}
+
+	// Draining thread only - the registry lock keeps drains from overlapping
+	template<typename CallbackType>
+	void Drain(CallbackType&& Callback)
+	{
+		const uint32 drained = Active.load(std::memory_order_relaxed);
+		Active.store(drained ^ 1, std::memory_order_seq_cst);
+		while (Sets[drained].bBusy.load(std::memory_order_seq_cst)) {
+			FPlatformProcess::Sleep(0.0f);
+		}
+
+		// Values are reset rather than removed, the thread will most likely record the same metrics again
+		TArray<FMetricsThreadValue>& values = Sets[drained].Values;
+		for (int32 id = 0; id < values.Num(); id++) {
+			FMetricsThreadValue& value = values[id];
+			if (!value.bUpdated) continue;
+
+			Callback((uint32)id, value);
+			value.Durations.Reset();
+			value.Value = 0.0;
+			value.SetCycles = 0;
+			value.bUpdated = false;
+		}
+	}
+
+	// Set when the owning thread exits, so the buffer can go once it is drained
+	std::atomic<bool> bThreadExited{ false };
+
+private:
+	struct FValueSet
+	{
+		// Indexed by metric id
+		TArray<FMetricsThreadValue> Values;
+		alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<bool> bBusy{ false };
+	};
+
+	FValueSet Sets[2];
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Active{ 0 };
+};
+
+/**
+ * The registered metrics, and the buffers of every thread that has recorded one.
+ *
+ * Metrics are identified by their name and kind. An id is never reused, so records still buffered for a metric whose
+ * sites have all unregistered can be looked up.
+ */
+class FMetricsRecorderRegistry
+{
+public:
+	static uint32 RegisterMetric(const ANSICHAR* Name, EMetricKind Kind);
+	static void UnregisterMetric(uint32 Id);
+
+	// Name and kind of a metric. Returns whether any site still has it registered.
+	static bool GetMetric(uint32 Id, FName& OutName, EMetricKind& OutKind);
+
+	// Buffer for the calling thread, created on its first record
+	static FMetricsThreadBuffer& GetThreadBuffer();
+
+	// Passes what every thread recorded for each metric since the last drain to Callback - drains from several threads take turns
+	static void Drain(TFunctionRef<void(uint32 MetricId, const FMetricsThreadValue& Value)> Callback);
+};
@@ -0,0 +1,285 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsResourceSampler.h"
+#include "HAL/RunnableThread.h"
+
+#include "MetricsLoggerSettings.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#elif PLATFORM_MAC
+#include <libproc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Enough for several hours at the default interval - older samples are overwritten
+const int32 RESOURCE_SAMPLE_CAPACITY = 16384;
+
+#if PLATFORM_WINDOWS
+static double FileTimeToSeconds(const FILETIME& Time)
+{
+	// FILETIME counts 100 nanosecond intervals
+	return ((uint64)Time.dwHighDateTime << 32 | Time.dwLowDateTime) * 1e-7;
+}
+#elif PLATFORM_LINUX
+// Reads a small /proc file into Buffer without allocating - /proc files report a size of zero so they can't be sized up front
+static bool ReadProcFile(const ANSICHAR* Path, ANSICHAR* Buffer, int32 BufferSize)
+{
+	const int fd = open(Path, O_RDONLY);
+	if (fd < 0) return false;
+
+	const ssize_t length = read(fd, Buffer, BufferSize - 1);
+	close(fd);
+	if (length <= 0) return false;
+
+	Buffer[length] = 0;
+	return true;
+}
+
+// Parses the next whitespace separated number, advancing Cursor past it
+static uint64 ParseNext(const ANSICHAR*& Cursor)
+{
+	ANSICHAR* end = nullptr;
+	const uint64 value = FCStringAnsi::Strtoui64(Cursor, &end, 10);
+	Cursor = end;
+	return value;
+}
+
+// Finds "Key:" at the start of a line and parses the number after it
+static bool ParseKeyValue(const ANSICHAR* Buffer, const ANSICHAR* Key, uint64& OutValue)
+{
+	const ANSICHAR* found = FCStringAnsi::Strstr(Buffer, Key);
+	if (!found) return false;
+
+	const ANSICHAR* cursor = found + FCStringAnsi::Strlen(Key);
+	OutValue = ParseNext(cursor);
+	return true;
+}
+#endif
+
+void FMetricsResourceSampler::ReadSample(FSample& OutSample)
+{
+	OutSample = FSample();
+	OutSample.Time = FPlatformTime::Seconds();
+	OutSample.WorkingSetBytes = FPlatformMemory::GetStats().UsedPhysical;
+
+#if PLATFORM_WINDOWS
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+		OutSample.ProcessCpuSeconds = FileTimeToSeconds(kernelTime) + FileTimeToSeconds(userTime);
+	}
+
+	// Kernel time includes the idle time
+	FILETIME idleTime;
+	if (GetSystemTimes(&idleTime, &kernelTime, &userTime)) {
+		OutSample.SystemTotalSeconds = FileTimeToSeconds(kernelTime) + FileTimeToSeconds(userTime);
+		OutSample.SystemBusySeconds = OutSample.SystemTotalSeconds - FileTimeToSeconds(idleTime);
+	}
+
+	IO_COUNTERS ioCounters;
+	if (GetProcessIoCounters(GetCurrentProcess(), &ioCounters)) {
+		OutSample.IoReadBytes = ioCounters.ReadTransferCount;
+		OutSample.IoWriteBytes = ioCounters.WriteTransferCount;
+		OutSample.bHasIo = true;
+	}
+#elif PLATFORM_LINUX
+	static const double secondsPerTick = 1.0 / FMath::Max(sysconf(_SC_CLK_TCK), 1L);
+	ANSICHAR buffer[1024];
+
+	// The command name in brackets can contain spaces, so fields are counted from the closing bracket.
+	// utime and stime are the 12th and 13th fields after it.
+	if (ReadProcFile("/proc/self/stat", buffer, sizeof(buffer))) {
+		const ANSICHAR* cursor = FCStringAnsi::Strrchr(buffer, ')');
+		if (cursor) {
+			cursor += 2;
+			while (*cursor && *cursor != ' ') cursor++;
+			for (int32 i = 0; i < 10; i++) {
+				ParseNext(cursor);
+			}
+			const uint64 userTicks = ParseNext(cursor);
+			const uint64 systemTicks = ParseNext(cursor);
+			OutSample.ProcessCpuSeconds = (userTicks + systemTicks) * secondsPerTick;
+		}
+	}
+
+	// The first line adds up every core: user nice system idle iowait irq softirq steal
+	if (ReadProcFile("/proc/stat", buffer, sizeof(buffer)) && FCStringAnsi::Strncmp(buffer, "cpu ", 4) == 0) {
+		const ANSICHAR* cursor = buffer + 4;
+		uint64 ticks[8];
+		uint64 totalTicks = 0;
+		for (int32 i = 0; i < 8; i++) {
+			ticks[i] = ParseNext(cursor);
+			totalTicks += ticks[i];
+		}
+		OutSample.SystemTotalSeconds = totalTicks * secondsPerTick;
+		OutSample.SystemIoWaitSeconds = ticks[4] * secondsPerTick;
+		OutSample.SystemBusySeconds = (totalTicks - ticks[3] - ticks[4]) * secondsPerTick;
+	}
+
+	// Bytes that actually went to or from storage, rather than through the page cache
+	if (ReadProcFile("/proc/self/io", buffer, sizeof(buffer))) {
+		OutSample.bHasIo = ParseKeyValue(buffer, "\nread_bytes:", OutSample.IoReadBytes) && ParseKeyValue(buffer, "\nwrite_bytes:", OutSample.IoWriteBytes);
+	}
+#elif PLATFORM_MAC
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		OutSample.ProcessCpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+	}
+
+	rusage_info_v2 info;
+	if (proc_pid_rusage(getpid(), RUSAGE_INFO_V2, (rusage_info_t*)&info) == 0) {
+		OutSample.IoReadBytes = info.ri_diskio_bytesread;
+		OutSample.IoWriteBytes = info.ri_diskio_byteswritten;
+		OutSample.bHasIo = true;
+	}
+#endif
+}
+
+FMetricsResourceSampler::FMetricsResourceSampler()
+{
+	NumCores = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1);
+}
+
+FMetricsResourceSampler::~FMetricsResourceSampler()
+{
+	if (Thread) {
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeEvent) {
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+}
+
+FMetricsResourceSampler::FSession FMetricsResourceSampler::BeginSession()
+{
+	FSession session;
+	const UMetricsLoggerSettings* settings = GetDefault<UMetricsLoggerSettings>();
+	if (!settings->EnableResourceSampling) return session;
+
+	IntervalMilliseconds = (uint32)FMath::Max(settings->ResourceSampleInterval * 1000.0f, 1.0f);
+
+	// Nothing is sampled until the first session, so most editor sessions never start the thread
+	if (!Thread) {
+		Samples.SetNumUninitialized(RESOURCE_SAMPLE_CAPACITY);
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("MetricsLoggerResourceSampler"), 0, TPri_Lowest);
+	}
+
+	session.bActive = true;
+	ReadSample(session.Start);
+	{
+		FScopeLock lock(&Lock);
+		session.FirstSample = NumSamples;
+		ActiveSessions++;
+	}
+	WakeEvent->Trigger();
+
+	return session;
+}
+
+void FMetricsResourceSampler::EndSession(FSession& Session, EventMetaData& Event)
+{
+	if (!Session.bActive) return;
+	Session.bActive = false;
+
+	FSample end;
+	ReadSample(end);
+
+	// Peaks come from the samples taken during the session, or as many of them as the ring still holds
+	uint64 peakWorkingSet = FMath::Max(Session.Start.WorkingSetBytes, end.WorkingSetBytes);
+	double peakCpu = 0.0;
+	int32 numSamples = 0;
+	{
+		FScopeLock lock(&Lock);
+		ActiveSessions--;
+
+		const uint64 oldestSample = NumSamples > (uint64)RESOURCE_SAMPLE_CAPACITY ? NumSamples - RESOURCE_SAMPLE_CAPACITY : 0;
+		const FSample* previous = &Session.Start;
+		for (uint64 i = FMath::Max(Session.FirstSample, oldestSample); i < NumSamples; i++) {
+			const FSample& sample = Samples[i % RESOURCE_SAMPLE_CAPACITY];
+			peakWorkingSet = FMath::Max(peakWorkingSet, sample.WorkingSetBytes);
+			peakCpu = FMath::Max(peakCpu, GetCpuUtilization(*previous, sample));
+			previous = &sample;
+			numSamples++;
+		}
+		peakCpu = FMath::Max(peakCpu, GetCpuUtilization(*previous, end));
+	}
+
+	const FSample& start = Session.Start;
+	Event.AddField("resource_samples", numSamples);
+	Event.AddField("resource_cpu_mean", GetCpuUtilization(start, end));
+	Event.AddField("resource_cpu_peak", peakCpu);
+	Event.AddField("resource_working_set_peak", peakWorkingSet);
+
+	const double systemSeconds = end.SystemTotalSeconds - start.SystemTotalSeconds;
+	if (systemSeconds > 0.0) {
+		Event.AddField("resource_system_cpu_mean", 100.0 * (end.SystemBusySeconds - start.SystemBusySeconds) / systemSeconds);
+		Event.AddField("resource_system_iowait_mean", 100.0 * (end.SystemIoWaitSeconds - start.SystemIoWaitSeconds) / systemSeconds);
+	}
+	if (start.bHasIo && end.bHasIo) {
+		Event.AddField("resource_io_read_bytes", end.IoReadBytes - start.IoReadBytes);
+		Event.AddField("resource_io_write_bytes", end.IoWriteBytes - start.IoWriteBytes);
+	}
+}
+
+double FMetricsResourceSampler::GetCpuUtilization(const FSample& From, const FSample& To) const
+{
+	const double seconds = To.Time - From.Time;
+	return seconds > 0.0 ? 100.0 * (To.ProcessCpuSeconds - From.ProcessCpuSeconds) / (seconds * NumCores) : 0.0;
+}
+
+uint32 FMetricsResourceSampler::Run()
+{
+	while (!bStopping) {
+		bool active;
+		{
+			FScopeLock lock(&Lock);
+			active = ActiveSessions > 0;
+		}
+
+		// Sleep until the next session starts
+		if (!active) {
+			WakeEvent->Wait();
+			continue;
+		}
+
+		FSample sample;
+		ReadSample(sample);
+		{
+			FScopeLock lock(&Lock);
+			Samples[NumSamples % RESOURCE_SAMPLE_CAPACITY] = sample;
+			NumSamples++;
+		}
+
+		WakeEvent->Wait(IntervalMilliseconds);
+	}
+
+	return 0;
+}
+
+void FMetricsResourceSampler::Stop()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+#include "MetricsModel.h"
+
+#include <atomic>
+
+/**
+ * Samples how much CPU, memory and IO the process uses while a cook, package or shader session is running.
+ *
+ * A low priority thread reads the process and machine counters at ResourceSampleInterval into a ring buffer allocated
+ * when it starts, and sleeps whenever no session is active. When a session ends its CPU utilization, peak working set
+ * and IO are summarized from the samples taken since it began and added to its event as resource_ fields.
+ */
+class FMetricsResourceSampler: public FRunnable
+{
+public:
+	// Cumulative counters at a point in time - only the differences between samples mean anything
+	struct FSample
+	{
+		double Time{ 0.0 };
+		double ProcessCpuSeconds{ 0.0 };
+		double SystemBusySeconds{ 0.0 };
+		double SystemIoWaitSeconds{ 0.0 };
+		double SystemTotalSeconds{ 0.0 };
+		uint64 WorkingSetBytes{ 0 };
+		uint64 IoReadBytes{ 0 };
+		uint64 IoWriteBytes{ 0 };
+		bool bHasIo{ false };
+	};
+
+	struct FSession
+	{
+		bool bActive{ false };
+		FSample Start;
+		uint64 FirstSample{ 0 };
+	};
+
+	FMetricsResourceSampler();
+	virtual ~FMetricsResourceSampler();
+
+	// Starts sampling if no other session is running. Returns an inactive session if sampling is turned off.
+	FSession BeginSession();
+
+	// Adds the resources used since the session began to Event
+	void EndSession(FSession& Session, EventMetaData& Event);
+
+	// FRunnable overrides
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	// Reads the counters from the OS - values a platform can't provide are left at zero
+	static void ReadSample(FSample& OutSample);
+
+private:
+	// Utilization of every logical core between two samples, in percent
+	double GetCpuUtilization(const FSample& From, const FSample& To) const;
+
+	FRunnableThread* Thread{ nullptr };
+	FEvent* WakeEvent{ nullptr };
+	std::atomic<bool> bStopping{ false };
+	std::atomic<uint32> IntervalMilliseconds{ 1000 };
+	int32 NumCores{ 1 };
+
+	// Ring of the latest samples and how many have been taken in all, guarded by Lock
+	FCriticalSection Lock;
+	TArray<FSample> Samples;
+	uint64 NumSamples{ 0 };
+	int32 ActiveSessions{ 0 };
+};
@@ -0,0 +1,91 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsRetryPolicy.h"
+#include "HAL/PlatformProcess.h"
+#include "Interfaces/IHttpResponse.h"
+#include "MetricsLogCategory.h"
+
+// Longest Retry-After that is honoured, in case the server asks for something unreasonable
+const double RETRY_AFTER_MAX = 3600.0;
+
+FMetricsRetryPolicy::FMetricsRetryPolicy(double InMinDelay, double InMaxDelay, int32 InFailureThreshold, double InOpenDuration)
+	: MinDelay(FMath::Max(InMinDelay, 0.1))
+	, MaxDelay(FMath::Max(InMaxDelay, InMinDelay))
+	, FailureThreshold(FMath::Max(InFailureThreshold, 1))
+	, OpenDuration(InOpenDuration)
+	// Seeded per process so editors started together still spread out
+	, Random((int32)(FPlatformTime::Cycles() ^ FPlatformProcess::GetCurrentProcessId()))
+{
+}
+
+EMetricsSendResult FMetricsRetryPolicy::Classify(bool bWasSuccessful, int32 ResponseCode)
+{
+	// There's no response at all if the endpoint couldn't be reached
+	if (!bWasSuccessful || ResponseCode == 0) return EMetricsSendResult::Retryable;
+
+	if (EHttpResponseCodes::IsOk(ResponseCode)) return EMetricsSendResult::Success;
+
+	// Rate limiting and timeouts say nothing about the content
+	if (ResponseCode == EHttpResponseCodes::TooManyRequests || ResponseCode == EHttpResponseCodes::RequestTimeout) return EMetricsSendResult::Retryable;
+
+	if (ResponseCode >= 500) return EMetricsSendResult::Retryable;
+
+	// Any other client error (or a redirect, which means the URL is wrong) won't go away by itself
+	return EMetricsSendResult::Rejected;
+}
+
+double FMetricsRetryPolicy::ParseRetryAfter(const FString& Value)
+{
+	if (Value.IsEmpty()) return -1.0;
+
+	if (Value.IsNumeric()) {
+		return FMath::Min(FCString::Atod(*Value), RETRY_AFTER_MAX);
+	}
+
+	FDateTime retryTime;
+	if (FDateTime::ParseHttpDate(Value, retryTime)) {
+		return FMath::Clamp((retryTime - FDateTime::UtcNow()).GetTotalSeconds(), 0.0, RETRY_AFTER_MAX);
+	}
+	return -1.0;
+}
+
+void FMetricsRetryPolicy::OnSuccess()
+{
+	if (IsOpen()) {
+		UE_LOG(MetricsLog, Log, TEXT("Metrics endpoint is reachable again."));
+	}
+
+	ConsecutiveFailures = 0;
+	Delay = 0.0;
+	NextAttemptTime = 0.0;
+}
+
+void FMetricsRetryPolicy::OnFailure(double RetryAfter)
+{
+	ConsecutiveFailures++;
+
+	const double upper = FMath::Max(Delay * 3.0, MinDelay);
+	Delay = FMath::Min(MaxDelay, MinDelay + Random.GetFraction() * (upper - MinDelay));
+
+	double wait = FMath::Max(Delay, RetryAfter);
+	if (IsOpen()) {
+		if (ConsecutiveFailures == FailureThreshold) {
+			UE_LOG(MetricsLog, Warning, TEXT("Metrics endpoint failed %d times in a row - holding off for %.0f seconds."), ConsecutiveFailures, FMath::Max(wait, OpenDuration));
+		}
+		wait = FMath::Max(wait, OpenDuration);
+	}
+	NextAttemptTime = FPlatformTime::Seconds() + wait;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+/**
+ * How a failed write should be handled, going by the HTTP response.
+ */
+enum class EMetricsSendResult
+{
+	// Written
+	Success,
+	// The endpoint couldn't take the batch right now - keep it and try again later
+	Retryable,
+	// The endpoint rejected the batch itself - sending it again won't help
+	Rejected
+};
+
+/**
+ * Decides when the next attempt to write to an endpoint may be made.
+ *
+ * Delays between retries grow with decorrelated jitter - each one is picked at random between the minimum delay and
+ * three times the previous one - so a fleet of editors that lost the endpoint at the same moment doesn't come back
+ * in lockstep. A Retry-After from the server is honoured when it asks for longer. After enough consecutive failures
+ * the circuit opens and no requests are made at all until it has been open for a while, then a single probe decides
+ * whether it closes again.
+ *
+ * Not thread safe - callers hold their own lock.
+ */
+class FMetricsRetryPolicy
+{
+public:
+	FMetricsRetryPolicy(double InMinDelay, double InMaxDelay, int32 InFailureThreshold, double InOpenDuration);
+
+	static EMetricsSendResult Classify(bool bWasSuccessful, int32 ResponseCode);
+
+	// Parses a Retry-After header value, either delay seconds or an HTTP date. Returns a negative value if there isn't one.
+	static double ParseRetryAfter(const FString& Value);
+
+	void OnSuccess();
+
+	// RetryAfter is the delay the server asked for, or negative if it didn't
+	void OnFailure(double RetryAfter);
+
+	// Whether the next attempt is due
+	bool CanAttempt() const { return FPlatformTime::Seconds() >= NextAttemptTime; }
+
+	// While open every batch goes straight to the spool and only the probe is sent
+	bool IsOpen() const { return ConsecutiveFailures >= FailureThreshold; }
+
+private:
+	double MinDelay;
+	double MaxDelay;
+	int32 FailureThreshold;
+	double OpenDuration;
+
+	int32 ConsecutiveFailures{ 0 };
+	double Delay{ 0.0 };
+	double NextAttemptTime{ 0.0 };
+	FRandomStream Random;
+};
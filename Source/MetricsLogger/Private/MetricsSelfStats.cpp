@@ -0,0 +1,88 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsSelfStats.h"
+#include "MetricsClock.h"
+
+FMetricsSelfStats::FMetricsSelfStats()
+	: LastReportTime(FMetricsClock::Now())
+{
+}
+
+FMetricsSelfStats& FMetricsSelfStats::Get()
+{
+	static FMetricsSelfStats Instance;
+	return Instance;
+}
+
+FMetricsSelfStats::FGameThreadScope::~FGameThreadScope()
+{
+	const uint64 cycles = FPlatformTime::Cycles64() - StartCycles;
+
+	FMetricsSelfStats& stats = FMetricsSelfStats::Get();
+	Add(stats.GameThreadCycles, cycles);
+	Add(stats.GameThreadCalls);
+
+	uint64 maxCycles = stats.GameThreadMaxCycles.load(std::memory_order_relaxed);
+	while (cycles > maxCycles && !stats.GameThreadMaxCycles.compare_exchange_weak(maxCycles, cycles, std::memory_order_relaxed)) {}
+}
+
+void FMetricsSelfStats::Report(int64 Now, uint32 QueueDepth, EventMetaData& OutData)
+{
+	FTotals totals;
+	totals.GameThreadCycles = GameThreadCycles.load(std::memory_order_relaxed);
+	totals.GameThreadCalls = GameThreadCalls.load(std::memory_order_relaxed);
+	totals.EventsLogged = EventsLogged.load(std::memory_order_relaxed);
+	totals.EventsDropped = EventsDropped.load(std::memory_order_relaxed);
+	totals.SerializeCycles = SerializeCycles.load(std::memory_order_relaxed);
+	totals.BytesSerialized = BytesSerialized.load(std::memory_order_relaxed);
+	totals.Batches = Batches.load(std::memory_order_relaxed);
+	totals.BatchesDropped = BatchesDropped.load(std::memory_order_relaxed);
+	totals.RequestsSent = RequestsSent.load(std::memory_order_relaxed);
+	totals.RequestsFailed = RequestsFailed.load(std::memory_order_relaxed);
+	totals.RequestsCompleted = RequestsCompleted.load(std::memory_order_relaxed);
+	totals.BytesSent = BytesSent.load(std::memory_order_relaxed);
+	totals.SendLatencyMicroseconds = SendLatencyMicroseconds.load(std::memory_order_relaxed);
+	const uint64 maxCycles = GameThreadMaxCycles.exchange(0, std::memory_order_relaxed);
+
+	const int64 intervalStart = LastReportTime;
+	LastReportTime = Now;
+
+	OutData.type = LogEventTypeEnum::INTERNAL;
+	OutData.startTime = intervalStart;
+	OutData.finishTime = Now;
+	OutData.duration = FMetricsClock::ToSeconds(Now - intervalStart);
+	OutData.success = true;
+
+	const uint64 completed = totals.RequestsCompleted - LastTotals.RequestsCompleted;
+	const uint64 latency = totals.SendLatencyMicroseconds - LastTotals.SendLatencyMicroseconds;
+
+	OutData.AddField("game_thread_ms", FPlatformTime::ToMilliseconds64(totals.GameThreadCycles - LastTotals.GameThreadCycles));
+	OutData.AddField("game_thread_calls", totals.GameThreadCalls - LastTotals.GameThreadCalls);
+	OutData.AddField("game_thread_max_us", FPlatformTime::ToMilliseconds64(maxCycles) * 1000.0);
+	OutData.AddField("events_logged", totals.EventsLogged - LastTotals.EventsLogged);
+	OutData.AddField("events_dropped", totals.EventsDropped - LastTotals.EventsDropped);
+	OutData.AddField("queue_depth", QueueDepth);
+	OutData.AddField("serialize_ms", FPlatformTime::ToMilliseconds64(totals.SerializeCycles - LastTotals.SerializeCycles));
+	OutData.AddField("bytes_serialized", totals.BytesSerialized - LastTotals.BytesSerialized);
+	OutData.AddField("batches", totals.Batches - LastTotals.Batches);
+	OutData.AddField("batches_dropped", totals.BatchesDropped - LastTotals.BatchesDropped);
+	OutData.AddField("requests_sent", totals.RequestsSent - LastTotals.RequestsSent);
+	OutData.AddField("requests_failed", totals.RequestsFailed - LastTotals.RequestsFailed);
+	OutData.AddField("bytes_sent", totals.BytesSent - LastTotals.BytesSent);
+	OutData.AddField("send_latency_ms_mean", completed > 0 ? latency / 1000.0 / completed : 0.0);
+
+	LastTotals = totals;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+#include "MetricsModel.h"
+
+#include <atomic>
+
+DECLARE_STATS_GROUP(TEXT("MetricsLogger"), STATGROUP_MetricsLogger, STATCAT_Advanced);
+
+/**
+ * Counters for the logger's own overhead and health, reported as metricslogger_internal points.
+ *
+ * They are bumped from every thread with relaxed atomics - each counter only needs to add up, nothing is ordered by
+ * them - so keeping count costs about as much as an uncontended increment. The same scopes also show up under
+ * "stat MetricsLogger" and in Unreal Insights.
+ */
+class FMetricsSelfStats
+{
+public:
+	FMetricsSelfStats();
+
+	static FMetricsSelfStats& Get();
+
+	static void Add(std::atomic<uint64>& Counter, uint64 Value = 1)
+	{
+		Counter.fetch_add(Value, std::memory_order_relaxed);
+	}
+
+	// Game thread time spent handling analytics events and ticking the monitor - the logger's share of a frame
+	std::atomic<uint64> GameThreadCycles{ 0 };
+	std::atomic<uint64> GameThreadCalls{ 0 };
+	std::atomic<uint64> GameThreadMaxCycles{ 0 };
+
+	// Pipeline
+	std::atomic<uint64> EventsLogged{ 0 };
+	std::atomic<uint64> EventsDropped{ 0 };
+	std::atomic<uint64> SerializeCycles{ 0 };
+	std::atomic<uint64> BytesSerialized{ 0 };
+	std::atomic<uint64> Batches{ 0 };
+	std::atomic<uint64> BatchesDropped{ 0 };
+
+	// InfluxDB requests
+	std::atomic<uint64> RequestsSent{ 0 };
+	std::atomic<uint64> RequestsFailed{ 0 };
+	std::atomic<uint64> RequestsCompleted{ 0 };
+	std::atomic<uint64> BytesSent{ 0 };
+	std::atomic<uint64> SendLatencyMicroseconds{ 0 };
+
+	/**
+	 * Times a scope on the game thread.
+	 */
+	class FGameThreadScope
+	{
+	public:
+		FGameThreadScope() : StartCycles(FPlatformTime::Cycles64()) {}
+		~FGameThreadScope();
+
+	private:
+		uint64 StartCycles;
+	};
+
+	// Fills in a metricslogger_internal point with what changed since the last one. QueueDepth is sampled by the caller.
+	void Report(int64 Now, uint32 QueueDepth, EventMetaData& OutData);
+
+private:
+	// Counter values at the last report
+	struct FTotals
+	{
+		uint64 GameThreadCycles{ 0 };
+		uint64 GameThreadCalls{ 0 };
+		uint64 EventsLogged{ 0 };
+		uint64 EventsDropped{ 0 };
+		uint64 SerializeCycles{ 0 };
+		uint64 BytesSerialized{ 0 };
+		uint64 Batches{ 0 };
+		uint64 BatchesDropped{ 0 };
+		uint64 RequestsSent{ 0 };
+		uint64 RequestsFailed{ 0 };
+		uint64 RequestsCompleted{ 0 };
+		uint64 BytesSent{ 0 };
+		uint64 SendLatencyMicroseconds{ 0 };
+	};
+	FTotals LastTotals;
+	int64 LastReportTime{ 0 };
+};
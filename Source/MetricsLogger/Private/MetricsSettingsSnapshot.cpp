@@ -0,0 +1,129 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsSettingsSnapshot.h"
+#include "Misc/ScopeLock.h"
+#include "MetricsLogCategory.h"
+
+FCriticalSection FMetricsSettings::Lock;
+TSharedPtr<const FMetricsSettingsSnapshot, ESPMode::ThreadSafe> FMetricsSettings::Current;
+std::atomic<uint32> FMetricsSettings::Version{ 0 };
+
+// The v1 API spells microseconds "u" while v2 uses "us"
+static const TCHAR* GetPrecisionParameter(TimestampPrecision precision, InfluxDBVersion version)
+{
+	switch (precision)
+	{
+		case TimestampPrecision::Milliseconds:
+			return TEXT("ms");
+		case TimestampPrecision::Microseconds:
+			return version == InfluxDBVersion::V1 ? TEXT("u") : TEXT("us");
+		case TimestampPrecision::Nanoseconds:
+			return TEXT("ns");
+		default:
+			return TEXT("s");
+	}
+}
+
+// Write URLs for the InfluxDB v1.8 API
+static bool ResolveWriteUrlsV1(const UMetricsLoggerSettings& Settings, FMetricsSettingsSnapshot& Snapshot)
+{
+	const FString& baseURL = Settings.InfluxURL;
+	const FString& db = Settings.InfluxDatabase;
+	const FString& user = Settings.InfluxUser;
+	const FString& pw = Settings.InfluxPassword;
+
+	// Check we have some form of valid data
+	if (baseURL.IsEmpty() || db.IsEmpty() || user.IsEmpty() || pw.IsEmpty()) return false;
+
+	for (int32 precision = 0; precision < NUM_TIMESTAMP_PRECISIONS; precision++) {
+		Snapshot.InfluxWriteUrls[precision] = FString::Printf(TEXT("%s/write?db=%s&u=%s&p=%s&precision=%s"), *baseURL, *db, *user, *pw, GetPrecisionParameter((TimestampPrecision)precision, InfluxDBVersion::V1));
+	}
+	return true;
+}
+
+// Write URLs for the InfluxDB 2.0+ API
+static bool ResolveWriteUrlsV2(const UMetricsLoggerSettings& Settings, FMetricsSettingsSnapshot& Snapshot)
+{
+	const FString& baseURL = Settings.InfluxURL;
+	const FString& token = Settings.InfluxToken;
+	const FString& org = Settings.InfluxOrganisation;
+	const FString& bucket = Settings.InfluxBucket;
+
+	// Check we have some form of valid data
+	if (baseURL.IsEmpty() || token.IsEmpty() || org.IsEmpty() || bucket.IsEmpty()) return false;
+
+	for (int32 precision = 0; precision < NUM_TIMESTAMP_PRECISIONS; precision++) {
+		Snapshot.InfluxWriteUrls[precision] = FString::Printf(TEXT("%s/api/v2/write?bucket=%s&org=%s&precision=%s"), *baseURL, *bucket, *org, GetPrecisionParameter((TimestampPrecision)precision, InfluxDBVersion::V2));
+	}
+	Snapshot.InfluxAuthorization = token;
+	return true;
+}
+
+void FMetricsSettings::Update()
+{
+	check(IsInGameThread());
+	const UMetricsLoggerSettings* Settings = GetDefault<UMetricsLoggerSettings>();
+
+	TSharedRef<FMetricsSettingsSnapshot, ESPMode::ThreadSafe> snapshot = MakeShared<FMetricsSettingsSnapshot, ESPMode::ThreadSafe>();
+	snapshot->EnableLogging = Settings->EnableLogging;
+	snapshot->LogUser = Settings->LogUser;
+	snapshot->Precision = Settings->Precision;
+
+	snapshot->bInfluxConfigured = Settings->InfluxVersion == InfluxDBVersion::V1 ? ResolveWriteUrlsV1(*Settings, *snapshot) : ResolveWriteUrlsV2(*Settings, *snapshot);
+	if (!snapshot->bInfluxConfigured && Settings->EnableLogging && Settings->EnableInfluxDBSink) {
+		UE_LOG(MetricsLog, Error, TEXT("Cannot log metrics to InfluxDB - incomplete configuration."));
+	}
+	snapshot->InfluxRequestTimeout = Settings->InfluxRequestTimeout;
+
+	snapshot->SpoolMaxBytes = (int64)Settings->SpoolMaxSizeMB * 1024 * 1024;
+	snapshot->RetryMinDelay = Settings->RetryMinDelay;
+	snapshot->RetryMaxDelay = Settings->RetryMaxDelay;
+	snapshot->CircuitBreakerThreshold = Settings->CircuitBreakerThreshold;
+	snapshot->CircuitBreakerOpenDuration = Settings->CircuitBreakerOpenDuration;
+
+	snapshot->BatchMaxPoints = Settings->BatchMaxPoints;
+	snapshot->BatchMaxBytes = Settings->BatchMaxBytes;
+	snapshot->BatchMaxLatency = Settings->BatchMaxLatency;
+	snapshot->CompressRequests = Settings->CompressRequests;
+	snapshot->CompressionMinBytes = Settings->CompressionMinBytes;
+	snapshot->EnableSummaries = Settings->EnableSummaries;
+	snapshot->SummaryInterval = Settings->SummaryInterval;
+	snapshot->CustomMetricInterval = Settings->CustomMetricInterval;
+	snapshot->EnableSelfTelemetry = Settings->EnableSelfTelemetry;
+	snapshot->SelfTelemetryInterval = Settings->SelfTelemetryInterval;
+
+	snapshot->FileSegmentMaxBytes = (int64)Settings->FileSegmentMaxSizeMB * 1024 * 1024;
+	snapshot->FileSegmentMaxAge = Settings->FileSegmentMaxAge;
+	snapshot->FileSyncInterval = Settings->FileSyncInterval;
+	snapshot->UdpFlushInterval = Settings->UdpFlushInterval;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		Current = snapshot;
+	}
+	Version.fetch_add(1, std::memory_order_release);
+}
+
+FMetricsSettingsRef FMetricsSettings::Get()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	// Logging stays off until the first snapshot is in
+	if (!Current.IsValid()) {
+		Current = MakeShared<FMetricsSettingsSnapshot, ESPMode::ThreadSafe>();
+	}
+	return Current.ToSharedRef();
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include "MetricsLoggerSettings.h"
+
+#include <atomic>
+
+/**
+ * Immutable copy of the settings the logger threads need, with everything derived from them worked out up front.
+ *
+ * UMetricsLoggerSettings is a UObject that the settings page edits on the game thread, so the logger threads never read
+ * it directly. Instead a new snapshot is built whenever the settings are modified and swapped in, and threads pick it
+ * up the next time they look.
+ */
+struct FMetricsSettingsSnapshot
+{
+	// Logging
+	bool EnableLogging{ false };
+	bool LogUser{ false };
+	TimestampPrecision Precision{ TimestampPrecision::Seconds };
+
+	// InfluxDB write endpoint for each precision and the authorization header to go with it - empty if incomplete
+	bool bInfluxConfigured{ false };
+	FString InfluxWriteUrls[NUM_TIMESTAMP_PRECISIONS];
+	FString InfluxAuthorization;
+	float InfluxRequestTimeout{ 30.0f };
+
+	// Spool and retries - only read when the InfluxDB sink is created
+	int64 SpoolMaxBytes{ 64 * 1024 * 1024 };
+	float RetryMinDelay{ 5.0f };
+	float RetryMaxDelay{ 300.0f };
+	int32 CircuitBreakerThreshold{ 5 };
+	float CircuitBreakerOpenDuration{ 600.0f };
+
+	// Batching
+	int32 BatchMaxPoints{ 100 };
+	int32 BatchMaxBytes{ 256 * 1024 };
+	double BatchMaxLatency{ 10.0 };
+	bool CompressRequests{ true };
+	int32 CompressionMinBytes{ 1024 };
+	bool EnableSummaries{ true };
+	double SummaryInterval{ 300.0 };
+	double CustomMetricInterval{ 60.0 };
+	bool EnableSelfTelemetry{ true };
+	double SelfTelemetryInterval{ 300.0 };
+
+	// Sinks
+	int64 FileSegmentMaxBytes{ 64 * 1024 * 1024 };
+	double FileSegmentMaxAge{ 3600.0 };
+	double FileSyncInterval{ 5.0 };
+	double UdpFlushInterval{ 10.0 };
+
+	const FString& GetInfluxWriteUrl(TimestampPrecision precision) const
+	{
+		return InfluxWriteUrls[(int32)precision];
+	}
+};
+
+typedef TSharedRef<const FMetricsSettingsSnapshot, ESPMode::ThreadSafe> FMetricsSettingsRef;
+
+/**
+ * Owner of the current settings snapshot.
+ */
+class FMetricsSettings
+{
+public:
+	// Builds a new snapshot from UMetricsLoggerSettings and swaps it in - game thread only
+	static void Update();
+
+	// The current snapshot, from any thread
+	static FMetricsSettingsRef Get();
+
+	// Changes every time a new snapshot is swapped in
+	static uint32 GetVersion() { return Version.load(std::memory_order_acquire); }
+
+private:
+	static FCriticalSection Lock;
+	static TSharedPtr<const FMetricsSettingsSnapshot, ESPMode::ThreadSafe> Current;
+	static std::atomic<uint32> Version;
+};
+
+/**
+ * A thread's reference to the current snapshot. The shared snapshot is only fetched again after a new one was swapped
+ * in, so reading the settings is an atomic load and a reference count the rest of the time.
+ */
+class FMetricsSettingsCache
+{
+public:
+	FMetricsSettingsCache() = default;
+
+	// Always returns Fixed rather than following the project settings
+	explicit FMetricsSettingsCache(const FMetricsSettingsRef& Fixed)
+		: Snapshot(Fixed)
+		, bFixed(true)
+	{
+	}
+
+	// Callers hold on to the returned reference for as long as they read from it - the next call may swap in a new
+	// snapshot and release the one the cache had
+	FMetricsSettingsRef Get()
+	{
+		if (!bFixed) {
+			const uint32 version = FMetricsSettings::GetVersion();
+			if (!Snapshot.IsValid() || version != CachedVersion) {
+				Snapshot = FMetricsSettings::Get();
+				CachedVersion = version;
+			}
+		}
+		return Snapshot.ToSharedRef();
+	}
+
+	// For reading a single setting - the snapshot is held until the end of the expression
+	FMetricsSettingsRef operator->()
+	{
+		return Get();
+	}
+
+private:
+	TSharedPtr<const FMetricsSettingsSnapshot, ESPMode::ThreadSafe> Snapshot;
+	uint32 CachedVersion{ 0 };
+	bool bFixed{ false };
+};
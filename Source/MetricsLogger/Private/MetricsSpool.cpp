@@ -0,0 +1,316 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsSpool.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Crc.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "MetricsLogCategory.h"
+
+// Header written in front of every batch
+struct FSpoolRecordHeader
+{
+	uint32 Size;
+	uint32 Crc;
+	uint32 Format;
+};
+
+FMetricsSpool::FMetricsSpool(const FString& InFilename, int64 InMaxSize)
+	: Filename(InFilename)
+	, HeadFilename(InFilename + TEXT(".head"))
+	, MaxSize(InMaxSize)
+{
+	Recover();
+}
+
+void FMetricsSpool::Append(const uint8* Data, int32 Size, uint32 Format)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	const int64 recordSize = sizeof(FSpoolRecordHeader) + Size;
+	if (recordSize > MaxSize) {
+		UE_LOG(MetricsLog, Warning, TEXT("Batch of %d bytes is larger than the spool - dropping it."), Size);
+		return;
+	}
+
+	// Evict the oldest batches until the new one fits
+	if (TailOffset + recordSize > MaxSize) {
+		int64 newHead = HeadOffset;
+		int32 evicted = 0;
+
+		MapRange(HeadOffset, TailOffset - HeadOffset, [&](const uint8* Mapped) {
+			while (newHead < TailOffset && TailOffset - newHead + recordSize > MaxSize) {
+				const int64 evictedSize = ReadRecordSize(Mapped + (newHead - HeadOffset), TailOffset - newHead);
+				newHead = evictedSize == INDEX_NONE ? TailOffset : newHead + evictedSize;
+				evicted++;
+			}
+		});
+
+		if (evicted > 0) {
+			UE_LOG(MetricsLog, Warning, TEXT("Spool is full - evicted the %d oldest batches."), evicted);
+		}
+		HeadSequence += evicted;
+		Compact(newHead);
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IFileHandle> handle(PlatformFile.OpenWrite(*Filename, true));
+	if (!handle) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not open spool file %s - dropping batch."), *Filename);
+		return;
+	}
+
+	FSpoolRecordHeader header;
+	header.Size = Size;
+	header.Crc = FCrc::MemCrc32(Data, Size);
+	header.Format = Format;
+
+	handle->Seek(TailOffset);
+	if (handle->Write((const uint8*)&header, sizeof(header)) && handle->Write(Data, Size)) {
+		TailOffset += recordSize;
+	}
+	else {
+		UE_LOG(MetricsLog, Error, TEXT("Could not write to spool file %s - dropping batch."), *Filename);
+	}
+}
+
+bool FMetricsSpool::Peek(TArray<uint8>& OutBatch, uint32& OutFormat, uint64* OutSequence) const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (HeadOffset >= TailOffset) return false;
+
+	if (OutSequence) {
+		*OutSequence = HeadSequence;
+	}
+	return MapRange(HeadOffset, TailOffset - HeadOffset, [&](const uint8* Mapped) {
+		const FSpoolRecordHeader* header = (const FSpoolRecordHeader*)Mapped;
+		OutBatch.Reset(header->Size);
+		OutBatch.Append(Mapped + sizeof(FSpoolRecordHeader), header->Size);
+		OutFormat = header->Format;
+	});
+}
+
+void FMetricsSpool::Pop()
+{
+	FScopeLock ScopeLock(&Lock);
+	Pop(HeadSequence);
+}
+
+bool FMetricsSpool::Pop(uint64 Sequence)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (HeadOffset >= TailOffset) return false;
+
+	// Popping now would remove the batch after the evicted one, which hasn't been delivered
+	if (Sequence != HeadSequence) {
+		UE_LOG(MetricsLog, Log, TEXT("Delivered batch had already been evicted from the spool."));
+		return false;
+	}
+
+	MapRange(HeadOffset, sizeof(FSpoolRecordHeader), [&](const uint8* Mapped) {
+		HeadOffset += sizeof(FSpoolRecordHeader) + ((const FSpoolRecordHeader*)Mapped)->Size;
+	});
+	HeadSequence++;
+
+	// Once everything has been delivered the file can go
+	if (HeadOffset >= TailOffset) {
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*Filename);
+		HeadOffset = 0;
+		TailOffset = 0;
+	}
+	SaveHead();
+	return true;
+}
+
+bool FMetricsSpool::IsEmpty() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return HeadOffset >= TailOffset;
+}
+
+void FMetricsSpool::Recover()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	// A compaction that was interrupted between removing the old file and moving the new one into place leaves only
+	// the new one. If the old file is still there the new one may be incomplete, so it goes.
+	const FString tempFilename = Filename + TEXT(".tmp");
+	if (PlatformFile.FileExists(*tempFilename)) {
+		if (!PlatformFile.FileExists(*Filename) && PlatformFile.MoveFile(*Filename, *tempFilename)) {
+			UE_LOG(MetricsLog, Log, TEXT("Restored spool file %s from an interrupted compaction."), *Filename);
+		}
+		else {
+			PlatformFile.DeleteFile(*tempFilename);
+		}
+	}
+
+	const int64 fileSize = PlatformFile.FileSize(*Filename);
+	if (fileSize <= 0) {
+		PlatformFile.DeleteFile(*HeadFilename);
+		return;
+	}
+
+	// Walk the records until the first one that doesn't check out. The saved head only counts if it falls between two
+	// of them - anything else means the two files don't belong together, and replaying everything is the safe choice.
+	const int64 savedHead = LoadHead();
+	int64 validSize = 0;
+	int32 numRecords = 0;
+	int32 numDelivered = 0;
+	MapRange(0, fileSize, [&](const uint8* Mapped) {
+		while (validSize < fileSize) {
+			const int64 recordSize = ReadRecordSize(Mapped + validSize, fileSize - validSize);
+			if (recordSize == INDEX_NONE) break;
+
+			validSize += recordSize;
+			numRecords++;
+
+			if (validSize == savedHead) {
+				HeadOffset = savedHead;
+				numDelivered = numRecords;
+			}
+		}
+	});
+
+	TailOffset = fileSize;
+	if (validSize < fileSize) {
+		UE_LOG(MetricsLog, Warning, TEXT("Spool file %s was damaged - discarding %lld bytes."), *Filename, fileSize - validSize);
+		TailOffset = validSize;
+		Compact(HeadOffset);
+	}
+	else if (HeadOffset > 0) {
+		// Drop the batches that were delivered last time
+		Compact(HeadOffset);
+	}
+
+	if (numRecords > numDelivered) {
+		UE_LOG(MetricsLog, Log, TEXT("Found %d unsent batches in %s."), numRecords - numDelivered, *Filename);
+	}
+}
+
+int64 FMetricsSpool::ReadRecordSize(const uint8* Data, int64 Available) const
+{
+	if (Available < (int64)sizeof(FSpoolRecordHeader)) return INDEX_NONE;
+
+	const FSpoolRecordHeader* header = (const FSpoolRecordHeader*)Data;
+	const int64 recordSize = sizeof(FSpoolRecordHeader) + (int64)header->Size;
+
+	if (recordSize > Available || FCrc::MemCrc32(Data + sizeof(FSpoolRecordHeader), header->Size) != header->Crc) {
+		return INDEX_NONE;
+	}
+	return recordSize;
+}
+
+void FMetricsSpool::Compact(int64 NewHead)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Nothing left to keep
+	if (NewHead >= TailOffset) {
+		PlatformFile.DeleteFile(*Filename);
+		HeadOffset = 0;
+		TailOffset = 0;
+		SaveHead();
+		return;
+	}
+
+	const FString tempFilename = Filename + TEXT(".tmp");
+	bool bWritten = false;
+	{
+		TUniquePtr<IFileHandle> handle(PlatformFile.OpenWrite(*tempFilename));
+		if (handle) {
+			MapRange(NewHead, TailOffset - NewHead, [&](const uint8* Mapped) {
+				bWritten = handle->Write(Mapped, TailOffset - NewHead) && handle->Flush(true);
+			});
+		}
+	}
+	if (!bWritten) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not compact spool file %s."), *Filename);
+		PlatformFile.DeleteFile(*tempFilename);
+		HeadOffset = NewHead;
+		SaveHead();
+		return;
+	}
+
+	// The new file starts at its first record, so the saved head goes before the files are swapped. A crash before
+	// the swap then replays batches that were already delivered instead of applying the old head to the new file.
+	PlatformFile.DeleteFile(*HeadFilename);
+
+	if (!PlatformFile.DeleteFile(*Filename)) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not replace spool file %s."), *Filename);
+		PlatformFile.DeleteFile(*tempFilename);
+		HeadOffset = NewHead;
+		SaveHead();
+		return;
+	}
+
+	if (!PlatformFile.MoveFile(*Filename, *tempFilename)) {
+		if (!PlatformFile.CopyFile(*Filename, *tempFilename)) {
+			// The batches are only in the new file now - leave it for Recover to move into place next time
+			UE_LOG(MetricsLog, Error, TEXT("Could not move compacted spool file into place - %s will be restored on the next start."), *tempFilename);
+			HeadOffset = 0;
+			TailOffset = 0;
+			return;
+		}
+		PlatformFile.DeleteFile(*tempFilename);
+	}
+
+	TailOffset -= NewHead;
+	HeadOffset = 0;
+}
+
+void FMetricsSpool::SaveHead() const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (HeadOffset == 0) {
+		PlatformFile.DeleteFile(*HeadFilename);
+		return;
+	}
+
+	// The offset is followed by its complement so a torn write is never mistaken for a valid head
+	const uint64 record[2] = { (uint64)HeadOffset, ~(uint64)HeadOffset };
+	TUniquePtr<IFileHandle> handle(PlatformFile.OpenWrite(*HeadFilename));
+	if (!handle || !handle->Write((const uint8*)record, sizeof(record))) {
+		UE_LOG(MetricsLog, Warning, TEXT("Could not save the head of spool file %s - delivered batches may be sent again."), *Filename);
+	}
+}
+
+int64 FMetricsSpool::LoadHead() const
+{
+	uint64 record[2] = { 0, 0 };
+	TUniquePtr<IFileHandle> handle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*HeadFilename));
+	if (!handle || !handle->Read((uint8*)record, sizeof(record)) || record[1] != ~record[0]) return 0;
+
+	return (int64)record[0];
+}
+
+bool FMetricsSpool::MapRange(int64 Offset, int64 Size, TFunctionRef<void(const uint8*)> Callback) const
+{
+	if (Size <= 0) return false;
+
+	// The file is mapped per operation so no mapping is held open while the file is appended to or replaced
+	TUniquePtr<IMappedFileHandle> mappedHandle(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!mappedHandle) return false;
+
+	TUniquePtr<IMappedFileRegion> mappedRegion(mappedHandle->MapRegion(Offset, Size));
+	if (!mappedRegion) return false;
+
+	Callback(mappedRegion->GetMappedPtr());
+	return true;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Append-only file of line protocol batches that could not be delivered yet.
+ *
+ * Each batch is stored as a record with a size, checksum and caller defined format value (such as the timestamp
+ * precision the batch was serialized with) in its header so a torn write from a crash is detected and cut off
+ * the next time the spool is opened. Batches are appended at the tail and read back from the head through a read-only
+ * memory mapping. When the file would grow past its size cap the oldest batches are evicted first. The head is saved
+ * to a small file next to the spool whenever a batch is removed, so batches already delivered aren't replayed again
+ * after a restart.
+ *
+ * All functions are safe to call from any thread.
+ */
+class FMetricsSpool
+{
+public:
+	FMetricsSpool(const FString& InFilename, int64 InMaxSize);
+
+	// Adds a batch to the end of the spool
+	void Append(const uint8* Data, int32 Size, uint32 Format);
+
+	// Copies the oldest batch in the spool. Returns false if the spool is empty.
+	// OutSequence identifies the batch for Pop, which tells it apart from whatever takes its place if it is evicted.
+	bool Peek(TArray<uint8>& OutBatch, uint32& OutFormat, uint64* OutSequence = nullptr) const;
+
+	// Removes the oldest batch once it has been delivered
+	void Pop();
+
+	// Removes the oldest batch only if it is still the one Peek returned Sequence for. Returns false if that batch
+	// was evicted in the meantime, in which case nothing is removed.
+	bool Pop(uint64 Sequence);
+
+	bool IsEmpty() const;
+
+private:
+	// Checks the records already on disk and cuts off anything after the last valid one
+	void Recover();
+
+	// Size of the record starting at Offset, or INDEX_NONE if it is invalid
+	int64 ReadRecordSize(const uint8* Data, int64 Available) const;
+
+	// Rewrites the file so it only holds the records from NewHead onwards, through a temporary file that Recover
+	// moves into place if a crash interrupts the swap
+	void Compact(int64 NewHead);
+
+	// Saves HeadOffset next to the spool, or deletes the saved head once it is back at the start of the file
+	void SaveHead() const;
+
+	// The head saved by the last run, or 0 if there isn't a valid one
+	int64 LoadHead() const;
+
+	// Maps [Offset, Offset + Size) of the spool file and passes the bytes to Callback
+	bool MapRange(int64 Offset, int64 Size, TFunctionRef<void(const uint8*)> Callback) const;
+
+	FString Filename;
+	FString HeadFilename;
+	int64 MaxSize;
+
+	// Byte range of the records that are still waiting to be delivered
+	int64 HeadOffset{ 0 };
+	int64 TailOffset{ 0 };
+
+	// Number of batches removed from the head since the spool was opened, by delivery or eviction
+	uint64 HeadSequence{ 0 };
+
+	mutable FCriticalSection Lock;
+};
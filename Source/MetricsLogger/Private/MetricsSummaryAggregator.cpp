@@ -0,0 +1,66 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "MetricsSummaryAggregator.h"
+#include "MetricsClock.h"
+
+FMetricsSummaryAggregator::FMetricsSummaryAggregator()
+	: IntervalStart(FMetricsClock::Now())
+{
+}
+
+void FMetricsSummaryAggregator::Record(const EventMetaData& data)
+{
+	// Summaries and other aggregates aren't summarized again
+	if (MetricsLoggerUtils::IsAggregateEvent(data.type)) return;
+
+	const uint32 key = ((uint32)data.type << 1) | (data.success ? 1 : 0);
+	FSummary* summary = Summaries.Find(key);
+	if (!summary) {
+		summary = &Summaries.Add(key);
+		summary->Type = data.type;
+		summary->bSuccess = data.success;
+	}
+
+	summary->Durations.Record(data.duration);
+}
+
+void FMetricsSummaryAggregator::Summarize(int64 Now, TArray<EventMetaData>& OutSummaries)
+{
+	const int64 intervalStart = IntervalStart;
+	IntervalStart = Now;
+
+	for (TPair<uint32, FSummary>& entry : Summaries) {
+		FMetricsHistogram& durations = entry.Value.Durations;
+		if (durations.GetCount() == 0) continue;
+
+		EventMetaData& summary = OutSummaries.AddDefaulted_GetRef();
+		summary.type = LogEventTypeEnum::SUMMARY;
+		summary.startTime = intervalStart;
+		summary.finishTime = Now;
+		summary.duration = FMetricsClock::ToSeconds(Now - intervalStart);
+		summary.success = entry.Value.bSuccess;
+		summary.AddTag("event_type", MetricsLoggerUtils::LogEventTypeToFString(entry.Value.Type));
+		summary.AddField("count", durations.GetCount());
+		summary.AddField("duration_min", durations.GetMin());
+		summary.AddField("duration_mean", durations.GetMean());
+		summary.AddField("duration_p50", durations.GetPercentile(50.0));
+		summary.AddField("duration_p90", durations.GetPercentile(90.0));
+		summary.AddField("duration_p99", durations.GetPercentile(99.0));
+		summary.AddField("duration_max", durations.GetMax());
+
+		durations.Reset();
+	}
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsHistogram.h"
+#include "MetricsModel.h"
+
+/**
+ * Keeps a histogram of event durations per event type and success, and turns them into summary_event points.
+ *
+ * Dashboards can then read percentiles from one small series per interval rather than computing them over every raw
+ * point. Everything a process logs is for a single project, so the project is covered by the metadata tags of the
+ * summary points rather than being part of the key.
+ */
+class FMetricsSummaryAggregator
+{
+public:
+	FMetricsSummaryAggregator();
+
+	void Record(const EventMetaData& data);
+
+	// Adds a summary point for every histogram with values since the last call, then starts a new interval
+	void Summarize(int64 Now, TArray<EventMetaData>& OutSummaries);
+
+private:
+	struct FSummary
+	{
+		LogEventTypeEnum Type;
+		bool bSuccess;
+		FMetricsHistogram Durations;
+	};
+
+	TMap<uint32, FSummary> Summaries;
+	int64 IntervalStart{ 0 };
+};
@@ -0,0 +1,71 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Keeps the K heaviest items offered to it in a fixed-size min-heap.
+ *
+ * The lightest kept item sits at the top of the heap, so deciding whether a new item makes the cut is a single
+ * comparison and memory stays at K entries however many items are offered.
+ */
+template<typename ItemType>
+class TMetricsTopK
+{
+public:
+	struct FEntry
+	{
+		double Weight;
+		ItemType Item;
+	};
+
+	explicit TMetricsTopK(int32 InMaxItems)
+		: MaxItems(FMath::Max(InMaxItems, 0))
+	{
+		Entries.Reserve(MaxItems);
+	}
+
+	void Add(double Weight, const ItemType& Item)
+	{
+		if (Entries.Num() < MaxItems) {
+			Entries.HeapPush({ Weight, Item }, LighterFirst());
+		}
+		else if (MaxItems > 0 && Weight > Entries.HeapTop().Weight) {
+			Entries.HeapPopDiscard(LighterFirst(), false);
+			Entries.HeapPush({ Weight, Item }, LighterFirst());
+		}
+	}
+
+	// Kept items, heaviest first
+	TArray<FEntry> GetSorted() const
+	{
+		TArray<FEntry> sorted = Entries;
+		sorted.Sort([](const FEntry& A, const FEntry& B) { return A.Weight > B.Weight; });
+		return sorted;
+	}
+
+private:
+	struct LighterFirst
+	{
+		bool operator()(const FEntry& A, const FEntry& B) const
+		{
+			return A.Weight < B.Weight;
+		}
+	};
+
+	int32 MaxItems;
+	TArray<FEntry> Entries;
+};
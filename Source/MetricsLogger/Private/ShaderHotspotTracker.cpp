@@ -0,0 +1,107 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ShaderHotspotTracker.h"
+#include "IMetricsLogger.h"
+#include "MetricsTopK.h"
+#include "RHI.h"
+#include "ShaderCompiler.h"
+
+// Compiled permutations of one material (or global shader type) on one platform
+struct FCompiledShaders
+{
+	int32 Platform;
+	FString Name;
+	uint32 Compiled;
+};
+
+// The compiler stats are updated as jobs finish and the engine keeps their lock to itself, so they are copied out in
+// one pass rather than walked while each entry is looked up and ranked
+static TArray<FCompiledShaders> CopyCompiledShaders()
+{
+	TArray<FCompiledShaders> copy;
+	if (!GShaderCompilerStats) return copy;
+
+	const TSparseArray<FShaderCompilerStats::ShaderCompilerStats>& stats = GShaderCompilerStats->GetShaderCompilerStats();
+	for (TSparseArray<FShaderCompilerStats::ShaderCompilerStats>::TConstIterator it(stats); it; ++it) {
+		for (const auto& entry : *it) {
+			copy.Add({ it.GetIndex(), entry.Key, entry.Value.Compiled });
+		}
+	}
+	return copy;
+}
+
+void FShaderHotspotTracker::BeginSession()
+{
+	BaselineCounts.Reset();
+
+	for (const FCompiledShaders& shaders : CopyCompiledShaders()) {
+		BaselineCounts.Add(GetKey(shaders.Platform, shaders.Name), shaders.Compiled);
+	}
+}
+
+void FShaderHotspotTracker::EndSession(const EventMetaData& SessionEvent, double BusyWorkerSeconds, int32 MaxHotspots, IMetricsLogger& Logger)
+{
+	if (!GShaderCompilerStats || MaxHotspots <= 0) return;
+
+	struct FHotspot
+	{
+		int32 Platform;
+		const FString* Name;
+	};
+	TMetricsTopK<FHotspot> hotspots(MaxHotspots);
+	double totalCompiled = 0.0;
+
+	// Rank everything compiled since the session started. The totals only go down if the engine resets them, and those
+	// entries are skipped rather than wrapping around to a huge count.
+	const TArray<FCompiledShaders> compiledShaders = CopyCompiledShaders();
+	for (const FCompiledShaders& shaders : compiledShaders) {
+		const uint32* baseline = BaselineCounts.Find(GetKey(shaders.Platform, shaders.Name));
+		const uint32 compiled = !baseline ? shaders.Compiled : (shaders.Compiled > *baseline ? shaders.Compiled - *baseline : 0);
+
+		if (compiled > 0) {
+			totalCompiled += compiled;
+			hotspots.Add(compiled, { shaders.Platform, &shaders.Name });
+		}
+	}
+
+	int32 rank = 1;
+	for (const TMetricsTopK<FHotspot>::FEntry& hotspot : hotspots.GetSorted()) {
+		const double share = hotspot.Weight / totalCompiled;
+
+		EventMetaData eventData = EventMetaData();
+		eventData.type = LogEventTypeEnum::SHADER_HOTSPOT;
+		eventData.startTime = SessionEvent.startTime;
+		eventData.finishTime = SessionEvent.finishTime;
+		eventData.duration = BusyWorkerSeconds * share;
+		eventData.success = true;
+		eventData.parentSpanId = SessionEvent.spanId;
+
+		eventData.AddTag("material", **hotspot.Item.Name);
+		eventData.AddTag("platform", *LegacyShaderPlatformToShaderFormat((EShaderPlatform)hotspot.Item.Platform).ToString());
+		eventData.AddField("compiled_permutations", hotspot.Weight);
+		eventData.AddField("session_share", 100.0 * share);
+		eventData.AddField("rank", rank++);
+
+		Logger.Log(eventData);
+	}
+
+	BaselineCounts.Empty();
+}
+
+uint32 FShaderHotspotTracker::GetKey(int32 Platform, const FString& Name)
+{
+	return HashCombine(GetTypeHash(Name), GetTypeHash(Platform));
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MetricsModel.h"
+
+class IMetricsLogger;
+
+/**
+ * Works out which materials cost the most to compile during a shader compile session.
+ *
+ * The engine keeps running totals of compiled shader permutations per material (or global shader type) and platform.
+ * The totals are snapshotted when a session starts, and when it ends the difference is ranked so only the heaviest
+ * entries are logged rather than every one of the thousands of jobs in the session.
+ */
+class FShaderHotspotTracker
+{
+public:
+	void BeginSession();
+
+	// Logs a shader_hotspot_event for each of the heaviest entries, linked to the session by its span.
+	// Compile time isn't tracked per job, so each entry's duration is its share of the session's busy worker time.
+	void EndSession(const EventMetaData& SessionEvent, double BusyWorkerSeconds, int32 MaxHotspots, IMetricsLogger& Logger);
+
+private:
+	static uint32 GetKey(int32 Platform, const FString& Name);
+
+	// Compiled permutation counts when the session started
+	TMap<uint32, uint32> BaselineCounts;
+};
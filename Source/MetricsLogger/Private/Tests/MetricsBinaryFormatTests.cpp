@@ -0,0 +1,190 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "MetricsBinaryFormat.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static FString GetTestBinaryFilename(const TCHAR* Name)
+{
+	return FPaths::AutomationTransientDir() / TEXT("MetricsLogger") / Name;
+}
+
+static EventMetaData MakeTestEvent(int64 StartTime, const TCHAR* Map, double Memory)
+{
+	EventMetaData data;
+	data.type = LogEventTypeEnum::COOK;
+	data.startTime = StartTime;
+	data.finishTime = StartTime + 2500000000;
+	data.duration = 2.5;
+	data.success = true;
+	data.spanId = 42;
+	data.parentSpanId = 7;
+	data.AddTag("map", Map);
+	data.AddField("memory_mb", Memory);
+	return data;
+}
+
+static FString GetTagValue(const EventMetaData& Data, int32 Index)
+{
+	const EventTag& tag = Data.tags[Index];
+	FUTF8ToTCHAR value(Data.tagValues + tag.valueOffset, tag.valueLength);
+	return FString(value.Length(), value.Get());
+}
+
+// Writes a file with a block per batch and returns the offset each block ends at
+static TArray<int32> WriteTestFile(const FString& Filename, const TArray<TArray<EventMetaData>>& Batches)
+{
+	TSharedRef<FMetricsTags, ESPMode::ThreadSafe> tags = MakeShared<FMetricsTags, ESPMode::ThreadSafe>();
+	tags->Emplace(FString(TEXT("project")), FString(TEXT("Test")));
+
+	FMetricsBinaryWriter writer;
+	TArray<uint8> buffer;
+	MetricsBinaryFormat::WriteFileHeader(buffer);
+
+	TArray<int32> blockEnds;
+	for (const TArray<EventMetaData>& events : Batches) {
+		FMetricsBatch batch;
+		batch.Events = events;
+		batch.Tags = tags;
+		writer.WriteBlock(batch, buffer);
+		blockEnds.Add(buffer.Num());
+	}
+
+	FFileHelper::SaveArrayToFile(buffer, *Filename);
+	return blockEnds;
+}
+
+static void TruncateTestFile(const FString& Filename, int32 Size)
+{
+	TArray<uint8> contents;
+	FFileHelper::LoadFileToArray(contents, *Filename);
+	contents.SetNum(Size);
+	FFileHelper::SaveArrayToFile(contents, *Filename);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsBinaryRoundTripTest, "MetricsLogger.BinaryFormat.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsBinaryRoundTripTest::RunTest(const FString& Parameters)
+{
+	const int64 start = 1650000000000000000;
+	const FString filename = GetTestBinaryFilename(TEXT("RoundTrip.bin"));
+
+	// The second block only refers to strings the first one added to the dictionary
+	WriteTestFile(filename, {
+		{ MakeTestEvent(start, TEXT("Lobby"), 512.0), MakeTestEvent(start - 1000, TEXT("Arena"), 1024.0) },
+		{ MakeTestEvent(start + 5000, TEXT("Lobby"), 256.0) }
+		});
+
+	FMetricsBinaryReader reader;
+	if (!TestTrue(TEXT("The file opens"), reader.Open(filename))) return false;
+
+	TArray<EventMetaData> events;
+	FMetricsTags tags;
+	if (!TestTrue(TEXT("The first block is read"), reader.ReadBlock(events, tags))) return false;
+	if (!TestEqual(TEXT("Every event of the first block is read"), events.Num(), 2)) return false;
+
+	TestEqual(TEXT("Metadata tags are kept"), tags.Num(), 1);
+	if (tags.Num() == 1) {
+		TestEqual(TEXT("The metadata tag key is kept"), tags[0].Key, FString(TEXT("project")));
+		TestEqual(TEXT("The metadata tag value is kept"), tags[0].Value, FString(TEXT("Test")));
+	}
+
+	const EventMetaData& first = events[0];
+	TestEqual(TEXT("The type is kept"), (int32)first.type, (int32)LogEventTypeEnum::COOK);
+	TestTrue(TEXT("The success flag is kept"), first.success);
+	TestEqual(TEXT("The start time is kept to the nanosecond"), first.startTime, start);
+	TestEqual(TEXT("The finish time is kept to the nanosecond"), first.finishTime, start + 2500000000);
+	TestEqual(TEXT("The duration is kept"), first.duration, 2.5);
+	TestEqual(TEXT("The span id is kept"), first.spanId, (uint64)42);
+	TestEqual(TEXT("The parent span id is kept"), first.parentSpanId, (uint64)7);
+	TestEqual(TEXT("A start time before the previous event's survives the delta encoding"), events[1].startTime, start - 1000);
+
+	if (TestEqual(TEXT("The tag is kept"), first.numTags, 1)) {
+		TestEqual(TEXT("The tag key is kept"), FString(UTF8_TO_TCHAR(first.tags[0].key)), FString(TEXT("map")));
+		TestEqual(TEXT("The tag value is kept"), GetTagValue(first, 0), FString(TEXT("Lobby")));
+	}
+	if (TestEqual(TEXT("The field is kept"), first.numFields, 1)) {
+		TestEqual(TEXT("The field name is kept"), FString(UTF8_TO_TCHAR(first.fields[0].name)), FString(TEXT("memory_mb")));
+		TestEqual(TEXT("The field value is kept"), first.fields[0].value, 512.0);
+	}
+
+	if (!TestTrue(TEXT("The second block is read"), reader.ReadBlock(events, tags))) return false;
+	if (TestEqual(TEXT("Every event of the second block is read"), events.Num(), 1)) {
+		TestEqual(TEXT("Strings from the dictionary of an earlier block are resolved"), FString(UTF8_TO_TCHAR(events[0].fields[0].name)), FString(TEXT("memory_mb")));
+		TestEqual(TEXT("The field value of the second block is kept"), events[0].fields[0].value, 256.0);
+	}
+
+	TestFalse(TEXT("Reading stops at the end of the file"), reader.ReadBlock(events, tags));
+	TestFalse(TEXT("The end of the file isn't reported as damage"), reader.IsDamaged());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsBinaryTruncatedTest, "MetricsLogger.BinaryFormat.Truncated", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsBinaryTruncatedTest::RunTest(const FString& Parameters)
+{
+	const FString filename = GetTestBinaryFilename(TEXT("Truncated.bin"));
+
+	// Cut both in the middle of the second block's payload and in the middle of its header
+	const TArray<int32> blockEnds = WriteTestFile(filename, { { MakeTestEvent(1, TEXT("Lobby"), 1.0) }, { MakeTestEvent(2, TEXT("Arena"), 2.0) } });
+	for (const int32 size : { blockEnds[1] - 4, blockEnds[0] + 4 }) {
+		WriteTestFile(filename, { { MakeTestEvent(1, TEXT("Lobby"), 1.0) }, { MakeTestEvent(2, TEXT("Arena"), 2.0) } });
+		TruncateTestFile(filename, size);
+
+		FMetricsBinaryReader reader;
+		if (!TestTrue(TEXT("The file opens"), reader.Open(filename))) return false;
+
+		TArray<EventMetaData> events;
+		FMetricsTags tags;
+		TestTrue(TEXT("The complete block is read"), reader.ReadBlock(events, tags));
+		TestFalse(TEXT("The incomplete block isn't read"), reader.ReadBlock(events, tags));
+		TestTrue(TEXT("The incomplete block is reported as damage"), reader.IsDamaged());
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsBinaryCorruptTest, "MetricsLogger.BinaryFormat.Corrupt", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsBinaryCorruptTest::RunTest(const FString& Parameters)
+{
+	const FString filename = GetTestBinaryFilename(TEXT("Corrupt.bin"));
+	const TArray<int32> blockEnds = WriteTestFile(filename, { { MakeTestEvent(1, TEXT("Lobby"), 1.0) }, { MakeTestEvent(2, TEXT("Arena"), 2.0) } });
+
+	// Flip a bit in the first block's payload, which its checksum has to catch
+	TArray<uint8> contents;
+	FFileHelper::LoadFileToArray(contents, *filename);
+	contents[blockEnds[0] - 1] ^= 0x01;
+	FFileHelper::SaveArrayToFile(contents, *filename);
+
+	FMetricsBinaryReader reader;
+	if (!TestTrue(TEXT("The file opens"), reader.Open(filename))) return false;
+
+	TArray<EventMetaData> events;
+	FMetricsTags tags;
+	TestFalse(TEXT("The damaged block isn't read"), reader.ReadBlock(events, tags));
+	TestTrue(TEXT("The damaged block is reported"), reader.IsDamaged());
+	TestFalse(TEXT("Nothing is read after a damaged block"), reader.ReadBlock(events, tags));
+
+	// Anything that doesn't start with the magic number is refused outright
+	FFileHelper::SaveStringToFile(TEXT("cook_event,success=True event_duration=1.00 1"), *filename);
+	TestFalse(TEXT("A file of another format isn't opened"), reader.Open(filename));
+	return true;
+}
+
+#endif
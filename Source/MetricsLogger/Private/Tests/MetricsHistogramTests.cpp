@@ -0,0 +1,116 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#include "MetricsHistogram.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Percentiles are promised to within about 1.5% of the value
+static bool IsWithinBucketError(double Actual, double Expected)
+{
+	return FMath::Abs(Actual - Expected) <= Expected * 0.016;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsHistogramPercentileTest, "MetricsLogger.Histogram.Percentiles", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsHistogramPercentileTest::RunTest(const FString& Parameters)
+{
+	FMetricsHistogram histogram;
+	TestEqual(TEXT("An empty histogram has no percentiles"), histogram.GetPercentile(50.0), 0.0);
+
+	// 1ms to 1s, in a shuffled order
+	for (int32 i = 0; i < 1000; i++) {
+		histogram.Record(((i * 7919) % 1000 + 1) / 1000.0);
+	}
+
+	TestEqual(TEXT("Every value is counted"), histogram.GetCount(), (uint64)1000);
+	TestEqual(TEXT("The minimum is exact"), histogram.GetMin(), 0.001);
+	TestEqual(TEXT("The maximum is exact"), histogram.GetMax(), 1.0);
+	TestTrue(TEXT("The mean is exact"), FMath::IsNearlyEqual(histogram.GetMean(), 0.5005, 1e-9));
+	TestTrue(TEXT("p50 is within the bucket error"), IsWithinBucketError(histogram.GetPercentile(50.0), 0.5));
+	TestTrue(TEXT("p90 is within the bucket error"), IsWithinBucketError(histogram.GetPercentile(90.0), 0.9));
+	TestTrue(TEXT("p99 is within the bucket error"), IsWithinBucketError(histogram.GetPercentile(99.0), 0.99));
+	TestEqual(TEXT("p100 is the maximum"), histogram.GetPercentile(100.0), 1.0);
+	TestTrue(TEXT("p0 is within the bucket error of the minimum"), IsWithinBucketError(histogram.GetPercentile(0.0), 0.001));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsHistogramRangeTest, "MetricsLogger.Histogram.Range", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsHistogramRangeTest::RunTest(const FString& Parameters)
+{
+	// Small values are kept exactly, large ones stay within the bucket error
+	const double values[] = { 0.0, 0.000000005, 0.000000127, 0.000001, 0.000127, 0.05, 3.0, 4 * 3600.0 };
+	for (double value : values) {
+		FMetricsHistogram histogram;
+		histogram.Record(value);
+		histogram.Record(value);
+		const double p50 = histogram.GetPercentile(50.0);
+		TestTrue(FString::Printf(TEXT("A single value of %f is its own p50 (%f)"), value, p50), value == 0.0 ? p50 == 0.0 : IsWithinBucketError(p50, value));
+	}
+
+	// Negative durations can only come from a clock going backwards and count as zero
+	FMetricsHistogram histogram;
+	histogram.Record(-1.0);
+	TestEqual(TEXT("A negative duration is recorded as zero"), histogram.GetMax(), 0.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsHistogramMergeTest, "MetricsLogger.Histogram.Merge", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsHistogramMergeTest::RunTest(const FString& Parameters)
+{
+	FMetricsHistogram all;
+	FMetricsHistogram small;
+	FMetricsHistogram large;
+	for (int32 i = 1; i <= 1000; i++) {
+		const double value = i / 1000.0;
+		all.Record(value);
+		(i <= 100 ? small : large).Record(value);
+	}
+
+	// Merging into the histogram with fewer buckets has to grow it
+	small.Merge(large);
+	TestEqual(TEXT("Counts add up"), small.GetCount(), all.GetCount());
+	TestEqual(TEXT("The minimum is kept"), small.GetMin(), all.GetMin());
+	TestEqual(TEXT("The maximum is kept"), small.GetMax(), all.GetMax());
+	TestTrue(TEXT("The mean is the same"), FMath::IsNearlyEqual(small.GetMean(), all.GetMean(), 1e-9));
+	for (double percentile : { 50.0, 90.0, 99.0 }) {
+		TestEqual(FString::Printf(TEXT("p%.0f is the same as recording every value in one"), percentile), small.GetPercentile(percentile), all.GetPercentile(percentile));
+	}
+
+	FMetricsHistogram empty;
+	small.Merge(empty);
+	TestEqual(TEXT("Merging an empty histogram changes nothing"), small.GetMin(), all.GetMin());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsHistogramResetTest, "MetricsLogger.Histogram.Reset", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsHistogramResetTest::RunTest(const FString& Parameters)
+{
+	FMetricsHistogram histogram;
+	histogram.Record(2.0);
+	histogram.Reset();
+
+	TestEqual(TEXT("Nothing is counted after a reset"), histogram.GetCount(), (uint64)0);
+	TestEqual(TEXT("The minimum is cleared"), histogram.GetMin(), 0.0);
+	TestEqual(TEXT("The maximum is cleared"), histogram.GetMax(), 0.0);
+
+	histogram.Record(0.5);
+	TestEqual(TEXT("Values from before the reset don't count"), histogram.GetPercentile(100.0), 0.5);
+	return true;
+}
+
+#endif
@@ -0,0 +1,169 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#include "InfluxDBSink.h"
+#include "MetricsClock.h"
+#include "MetricsLoggerPipeline.h"
+#include "MetricsTestHttpServer.h"
+
+// These all talk to the stand-in server
+#if WITH_DEV_AUTOMATION_TESTS && WITH_METRICS_TEST_HTTP_SERVER
+
+static FString GetTestSinkSpoolFilename(const TCHAR* Name)
+{
+	const FString filename = FPaths::AutomationTransientDir() / TEXT("MetricsLogger") / Name;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteFile(*filename);
+	PlatformFile.DeleteFile(*(filename + TEXT(".head")));
+	return filename;
+}
+
+static FMetricsBatchRef MakeTestBatch(const TCHAR* LineProtocol)
+{
+	TSharedRef<FMetricsBatch, ESPMode::ThreadSafe> batch = MakeShared<FMetricsBatch, ESPMode::ThreadSafe>();
+	FTCHARToUTF8 utf8(LineProtocol);
+	batch->LineProtocol.Append((const uint8*)utf8.Get(), utf8.Length());
+	batch->Precision = TimestampPrecision::Nanoseconds;
+	return batch;
+}
+
+// Batches are gzipped on the way out and arrive intact
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsInfluxDBCompressedTest, "MetricsLogger.InfluxDB.Compressed", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FMetricsInfluxDBCompressedTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FMetricsTestHttpServer> server = MakeShared<FMetricsTestHttpServer>(TArray<int32>());
+	if (!TestTrue(TEXT("The stand-in server is listening"), server->IsListening())) return false;
+
+	const FString spoolFilename = GetTestSinkSpoolFilename(TEXT("Compressed.dat"));
+	TSharedPtr<FInfluxDBSink> sink = MakeShared<FInfluxDBSink>(server->MakeSettings(true), spoolFilename);
+
+	// Long enough to be worth compressing, and repetitive like real batches
+	FString lineProtocol;
+	for (int32 i = 0; i < 50; i++) {
+		lineProtocol += FString::Printf(TEXT("shader_event,success=True,project=Test event_duration=%d.00 %d\n"), i, i + 1);
+	}
+	sink->Submit(MakeTestBatch(*lineProtocol));
+
+	AddMetricsTestWait(this, TEXT("the batch to be accepted"), 10.0, [server]() {
+		return server->GetState().Accepted.Num() >= 1;
+	});
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, sink, spoolFilename, lineProtocol]() mutable {
+		const FMetricsTestHttpServer::FState& state = server->GetState();
+		TestEqual(TEXT("The batch is sent in one request"), state.NumRequests, 1);
+		TestEqual(TEXT("The request is gzipped"), state.NumCompressed, 1);
+		if (state.Accepted.Num() == 1) {
+			TestEqual(TEXT("The batch decompresses to what was submitted"), state.Accepted[0], lineProtocol);
+		}
+
+		sink.Reset();
+		TestFalse(TEXT("Nothing is spooled after a successful write"), FPlatformFileManager::Get().GetPlatformFile().FileExists(*spoolFilename));
+		return true;
+	}));
+
+	return true;
+}
+
+// A batch the endpoint rejects is dropped rather than spooled, so it can't hold up the batches behind it
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsInfluxDBRejectedTest, "MetricsLogger.InfluxDB.Rejected", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FMetricsInfluxDBRejectedTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FMetricsTestHttpServer> server = MakeShared<FMetricsTestHttpServer>(TArray<int32>{ 400 });
+	if (!TestTrue(TEXT("The stand-in server is listening"), server->IsListening())) return false;
+
+	const FString spoolFilename = GetTestSinkSpoolFilename(TEXT("Rejected.dat"));
+	TSharedPtr<FInfluxDBSink> sink = MakeShared<FInfluxDBSink>(server->MakeSettings(false), spoolFilename);
+
+	const TCHAR* rejected = TEXT("cook_event,success=True event_duration=bad 1\n");
+	const TCHAR* accepted = TEXT("cook_event,success=True event_duration=2.00 2\n");
+
+	sink->Submit(MakeTestBatch(rejected));
+	AddMetricsTestWait(this, TEXT("the first batch to be rejected"), 10.0, [server]() {
+		return server->GetState().NumRequests >= 1;
+	});
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([sink, accepted]() {
+		sink->Submit(MakeTestBatch(accepted));
+		return true;
+	}));
+
+	AddMetricsTestWait(this, TEXT("the second batch to be accepted"), 10.0, [server]() {
+		return server->GetState().Accepted.Num() >= 1;
+	});
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, sink, spoolFilename, accepted]() mutable {
+		const FMetricsTestHttpServer::FState& state = server->GetState();
+		TestEqual(TEXT("The rejected batch isn't retried"), state.NumRequests, 2);
+		if (state.Accepted.Num() == 1) {
+			TestEqual(TEXT("Only the valid batch is accepted"), state.Accepted[0], FString(accepted));
+		}
+
+		sink.Reset();
+		TestFalse(TEXT("The rejected batch isn't spooled"), FPlatformFileManager::Get().GetPlatformFile().FileExists(*spoolFilename));
+		return true;
+	}));
+
+	return true;
+}
+
+// Events logged through the pipeline are serialized, batched and written by the sink
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsInfluxDBPipelineTest, "MetricsLogger.InfluxDB.Pipeline", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FMetricsInfluxDBPipelineTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FMetricsTestHttpServer> server = MakeShared<FMetricsTestHttpServer>(TArray<int32>());
+	if (!TestTrue(TEXT("The stand-in server is listening"), server->IsListening())) return false;
+
+	const FMetricsSettingsRef settings = server->MakeSettings(true);
+	TArray<TUniquePtr<IMetricsSink>> sinks;
+	sinks.Add(MakeUnique<FInfluxDBSink>(settings, GetTestSinkSpoolFilename(TEXT("Pipeline.dat"))));
+	TSharedPtr<FMetricsLoggerPipeline> pipeline = MakeShared<FMetricsLoggerPipeline>(MoveTemp(sinks), settings);
+
+	const int64 now = FMetricsClock::Now();
+	EventMetaData data;
+	data.type = LogEventTypeEnum::COOK;
+	data.startTime = now - 1500000000;
+	data.finishTime = now;
+	data.duration = 1.5;
+	data.success = true;
+	data.AddTag("platform", TEXT("TestPlatform"));
+	data.AddField("packages", 12.0);
+	pipeline->Log(data);
+	pipeline->Flush();
+
+	AddMetricsTestWait(this, TEXT("the event to be written"), 10.0, [server]() {
+		return server->GetState().Accepted.ContainsByPredicate([](const FString& accepted) { return accepted.Contains(TEXT("cook_event")); });
+	});
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, pipeline, now]() mutable {
+		const FString* body = server->GetState().Accepted.FindByPredicate([](const FString& accepted) { return accepted.Contains(TEXT("cook_event")); });
+		if (body) {
+			TestTrue(TEXT("The event's tag is written"), body->Contains(TEXT("platform=TestPlatform")));
+			TestTrue(TEXT("The event's field is written"), body->Contains(TEXT("packages=12")));
+			TestTrue(TEXT("The finish time is written in nanoseconds"), body->Contains(FString::Printf(TEXT("event_finish=%lld"), now)));
+			TestTrue(TEXT("The point is timestamped with the start time"), body->Contains(FString::Printf(TEXT(" %lld\n"), now - 1500000000)));
+		}
+
+		pipeline.Reset();
+		return true;
+	}));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#include "MetricsRetryPolicy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsRetryClassifyTest, "MetricsLogger.RetryPolicy.Classify", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsRetryClassifyTest::RunTest(const FString& Parameters)
+{
+	struct FCase
+	{
+		bool bWasSuccessful;
+		int32 ResponseCode;
+		EMetricsSendResult Expected;
+	};
+	const FCase cases[] = {
+		// Connection failures and timeouts say nothing about the batch
+		{ false, 0, EMetricsSendResult::Retryable },
+		{ true, 0, EMetricsSendResult::Retryable },
+		{ false, 204, EMetricsSendResult::Retryable },
+		{ true, 200, EMetricsSendResult::Success },
+		{ true, 204, EMetricsSendResult::Success },
+		{ true, 408, EMetricsSendResult::Retryable },
+		{ true, 429, EMetricsSendResult::Retryable },
+		{ true, 500, EMetricsSendResult::Retryable },
+		{ true, 503, EMetricsSendResult::Retryable },
+		// The batch or the configuration is wrong, so sending it again won't help
+		{ true, 301, EMetricsSendResult::Rejected },
+		{ true, 400, EMetricsSendResult::Rejected },
+		{ true, 401, EMetricsSendResult::Rejected },
+		{ true, 404, EMetricsSendResult::Rejected },
+		{ true, 413, EMetricsSendResult::Rejected },
+	};
+
+	for (const FCase& test : cases) {
+		TestEqual(FString::Printf(TEXT("Response %d (%s) is classified"), test.ResponseCode, test.bWasSuccessful ? TEXT("completed") : TEXT("failed")),
+			(int32)FMetricsRetryPolicy::Classify(test.bWasSuccessful, test.ResponseCode), (int32)test.Expected);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsRetryAfterTest, "MetricsLogger.RetryPolicy.RetryAfter", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsRetryAfterTest::RunTest(const FString& Parameters)
+{
+	TestTrue(TEXT("No header means no delay was asked for"), FMetricsRetryPolicy::ParseRetryAfter(FString()) < 0.0);
+	TestTrue(TEXT("A value that is neither seconds nor a date is ignored"), FMetricsRetryPolicy::ParseRetryAfter(TEXT("soon")) < 0.0);
+	TestEqual(TEXT("Delay seconds are read"), FMetricsRetryPolicy::ParseRetryAfter(TEXT("120")), 120.0);
+	TestEqual(TEXT("An unreasonable delay is capped at an hour"), FMetricsRetryPolicy::ParseRetryAfter(TEXT("86400")), 3600.0);
+	TestEqual(TEXT("A date in the past means retry now"), FMetricsRetryPolicy::ParseRetryAfter(TEXT("Wed, 21 Oct 2015 07:28:00 GMT")), 0.0);
+
+	const double delay = FMetricsRetryPolicy::ParseRetryAfter((FDateTime::UtcNow() + FTimespan::FromSeconds(60.0)).ToHttpDate());
+	TestTrue(FString::Printf(TEXT("A date in the future is read as the delay until then (%f)"), delay), delay > 55.0 && delay <= 60.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsRetryCircuitTest, "MetricsLogger.RetryPolicy.Circuit", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsRetryCircuitTest::RunTest(const FString& Parameters)
+{
+	FMetricsRetryPolicy policy(10.0, 60.0, 3, 300.0);
+	TestTrue(TEXT("The first attempt can be made straight away"), policy.CanAttempt());
+
+	policy.OnFailure(-1.0);
+	TestFalse(TEXT("A failure delays the next attempt"), policy.CanAttempt());
+	TestFalse(TEXT("A single failure doesn't open the circuit"), policy.IsOpen());
+
+	policy.OnFailure(-1.0);
+	policy.OnFailure(-1.0);
+	TestTrue(TEXT("The circuit opens after enough failures in a row"), policy.IsOpen());
+	TestFalse(TEXT("No attempts are made while the circuit is open"), policy.CanAttempt());
+
+	policy.OnSuccess();
+	TestFalse(TEXT("A success closes the circuit"), policy.IsOpen());
+	TestTrue(TEXT("Attempts can be made again after a success"), policy.CanAttempt());
+	return true;
+}
+
+#endif
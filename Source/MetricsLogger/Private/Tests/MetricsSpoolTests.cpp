@@ -0,0 +1,255 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#include "InfluxDBSink.h"
+#include "MetricsSpool.h"
+#include "MetricsTestHttpServer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static FString GetTestSpoolFilename(const TCHAR* Name)
+{
+	const FString filename = FPaths::AutomationTransientDir() / TEXT("MetricsLogger") / Name;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteFile(*filename);
+	PlatformFile.DeleteFile(*(filename + TEXT(".head")));
+	PlatformFile.DeleteFile(*(filename + TEXT(".tmp")));
+	return filename;
+}
+
+static void AppendString(FMetricsSpool& Spool, const FString& Value, uint32 Format = 0)
+{
+	FTCHARToUTF8 utf8(*Value);
+	Spool.Append((const uint8*)utf8.Get(), utf8.Length(), Format);
+}
+
+static FString PeekString(const FMetricsSpool& Spool)
+{
+	TArray<uint8> batch;
+	uint32 format;
+	if (!Spool.Peek(batch, format)) return FString();
+
+	batch.Add(0);
+	return UTF8_TO_TCHAR((const ANSICHAR*)batch.GetData());
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolOrderTest, "MetricsLogger.Spool.Order", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolOrderTest::RunTest(const FString& Parameters)
+{
+	FMetricsSpool spool(GetTestSpoolFilename(TEXT("Order.dat")), 1024 * 1024);
+	TestTrue(TEXT("A new spool is empty"), spool.IsEmpty());
+
+	AppendString(spool, TEXT("first"), 1);
+	AppendString(spool, TEXT("second"), 2);
+
+	TArray<uint8> batch;
+	uint32 format = 0;
+	TestTrue(TEXT("Peek finds a batch"), spool.Peek(batch, format));
+	TestEqual(TEXT("The format is kept with the batch"), format, 1u);
+	TestEqual(TEXT("The oldest batch comes first"), PeekString(spool), FString(TEXT("first")));
+
+	spool.Pop();
+	TestEqual(TEXT("Pop moves on to the next batch"), PeekString(spool), FString(TEXT("second")));
+
+	spool.Pop();
+	TestTrue(TEXT("The spool is empty once every batch is popped"), spool.IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolRestartTest, "MetricsLogger.Spool.Restart", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolRestartTest::RunTest(const FString& Parameters)
+{
+	const FString filename = GetTestSpoolFilename(TEXT("Restart.dat"));
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		AppendString(spool, TEXT("first"));
+		AppendString(spool, TEXT("second"));
+		AppendString(spool, TEXT("third"));
+		spool.Pop();
+	}
+
+	// Delivered batches must not come back after a restart
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		TestEqual(TEXT("The spool resumes after the delivered batch"), PeekString(spool), FString(TEXT("second")));
+		spool.Pop();
+	}
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		TestEqual(TEXT("The spool resumes after both delivered batches"), PeekString(spool), FString(TEXT("third")));
+		spool.Pop();
+		TestTrue(TEXT("The spool is empty"), spool.IsEmpty());
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TestFalse(TEXT("The spool file is deleted once empty"), PlatformFile.FileExists(*filename));
+	TestFalse(TEXT("The saved head is deleted once empty"), PlatformFile.FileExists(*(filename + TEXT(".head"))));
+
+	FMetricsSpool spool(filename, 1024 * 1024);
+	TestTrue(TEXT("Nothing is replayed after everything was delivered"), spool.IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolDamagedTest, "MetricsLogger.Spool.Damaged", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolDamagedTest::RunTest(const FString& Parameters)
+{
+	const FString filename = GetTestSpoolFilename(TEXT("Damaged.dat"));
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		AppendString(spool, TEXT("first"));
+		AppendString(spool, TEXT("second"));
+	}
+
+	// A torn write leaves part of a record at the end
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const int64 validSize = PlatformFile.FileSize(*filename);
+	{
+		TUniquePtr<IFileHandle> handle(PlatformFile.OpenWrite(*filename, true));
+		const uint8 garbage[] = { 0x10, 0x00, 0x00, 0x00, 0xde, 0xad };
+		handle->Write(garbage, sizeof(garbage));
+	}
+
+	FMetricsSpool spool(filename, 1024 * 1024);
+	TestEqual(TEXT("The damaged record is cut off"), PlatformFile.FileSize(*filename), validSize);
+	TestEqual(TEXT("The first batch survives"), PeekString(spool), FString(TEXT("first")));
+	spool.Pop();
+	TestEqual(TEXT("The second batch survives"), PeekString(spool), FString(TEXT("second")));
+	spool.Pop();
+	TestTrue(TEXT("Nothing else is left"), spool.IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolInterruptedCompactTest, "MetricsLogger.Spool.InterruptedCompact", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolInterruptedCompactTest::RunTest(const FString& Parameters)
+{
+	const FString filename = GetTestSpoolFilename(TEXT("InterruptedCompact.dat"));
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		AppendString(spool, TEXT("first"));
+		AppendString(spool, TEXT("second"));
+	}
+
+	// Stop a compaction after the old file was deleted but before the new one was moved into place
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString tempFilename = filename + TEXT(".tmp");
+	TestTrue(TEXT("The new file is written"), PlatformFile.MoveFile(*tempFilename, *filename));
+
+	{
+		FMetricsSpool spool(filename, 1024 * 1024);
+		TestFalse(TEXT("The new file is moved into place"), PlatformFile.FileExists(*tempFilename));
+		TestEqual(TEXT("The first batch survives"), PeekString(spool), FString(TEXT("first")));
+	}
+
+	// A new file left next to the old one may be incomplete, and the old one still has every batch
+	TestTrue(TEXT("A partial new file is written"), PlatformFile.CopyFile(*tempFilename, *filename));
+	FMetricsSpool spool(filename, 1024 * 1024);
+	TestFalse(TEXT("The partial file is deleted"), PlatformFile.FileExists(*tempFilename));
+	TestEqual(TEXT("The first batch comes from the old file"), PeekString(spool), FString(TEXT("first")));
+	spool.Pop();
+	TestEqual(TEXT("The second batch comes from the old file"), PeekString(spool), FString(TEXT("second")));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolEvictionTest, "MetricsLogger.Spool.Eviction", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolEvictionTest::RunTest(const FString& Parameters)
+{
+	// Room for two of these records but not three
+	const FString batch = FString::ChrN(100, TEXT('x'));
+	FMetricsSpool spool(GetTestSpoolFilename(TEXT("Eviction.dat")), 250);
+
+	AppendString(spool, TEXT("1") + batch);
+	AppendString(spool, TEXT("2") + batch);
+	AppendString(spool, TEXT("3") + batch);
+
+	TestEqual(TEXT("The oldest batch is evicted"), PeekString(spool), TEXT("2") + batch);
+
+	// A batch being replayed can be evicted before its send completes, and must not take the next one with it
+	TArray<uint8> inFlight;
+	uint32 format;
+	uint64 sequence = 0;
+	spool.Peek(inFlight, format, &sequence);
+	AppendString(spool, TEXT("4") + batch);
+	TestFalse(TEXT("An evicted batch is not popped"), spool.Pop(sequence));
+	TestEqual(TEXT("The batch after the evicted one is kept"), PeekString(spool), TEXT("3") + batch);
+
+	spool.Peek(inFlight, format, &sequence);
+	TestTrue(TEXT("The batch at the head is popped"), spool.Pop(sequence));
+	TestEqual(TEXT("The newest batch is kept"), PeekString(spool), TEXT("4") + batch);
+	return true;
+}
+
+#if WITH_METRICS_TEST_HTTP_SERVER
+
+// A batch the endpoint fails to take is spooled and replayed until it gets through, with newer batches queued
+// behind it so everything arrives once and in order
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMetricsSpoolReplayTest, "MetricsLogger.Spool.Replay", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FMetricsSpoolReplayTest::RunTest(const FString& Parameters)
+{
+	TSharedRef<FMetricsTestHttpServer> server = MakeShared<FMetricsTestHttpServer>(TArray<int32>{ 503, 503 });
+	if (!TestTrue(TEXT("The stand-in server is listening"), server->IsListening())) return false;
+
+	const FString spoolFilename = GetTestSpoolFilename(TEXT("Replay.dat"));
+	TSharedPtr<FInfluxDBSink> sink = MakeShared<FInfluxDBSink>(server->MakeSettings(false), spoolFilename);
+
+	auto makeBatch = [](const TCHAR* LineProtocol) {
+		TSharedRef<FMetricsBatch, ESPMode::ThreadSafe> batch = MakeShared<FMetricsBatch, ESPMode::ThreadSafe>();
+		FTCHARToUTF8 utf8(LineProtocol);
+		batch->LineProtocol.Append((const uint8*)utf8.Get(), utf8.Length());
+		batch->Precision = TimestampPrecision::Nanoseconds;
+		return batch;
+	};
+	const TCHAR* first = TEXT("cook_event,success=True event_duration=1.00 1\n");
+	const TCHAR* second = TEXT("cook_event,success=True event_duration=2.00 2\n");
+
+	sink->Submit(makeBatch(first));
+
+	// Once the first batch has failed it is in the spool, and the second has to wait behind it
+	AddMetricsTestWait(this, TEXT("the first batch to be spooled"), 10.0, [spoolFilename]() {
+		return FPlatformFileManager::Get().GetPlatformFile().FileSize(*spoolFilename) > 0;
+	});
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([sink, makeBatch, second]() {
+		sink->Submit(makeBatch(second));
+		return true;
+	}));
+
+	AddMetricsTestWait(this, TEXT("both batches to be accepted"), 10.0, [server]() {
+		return server->GetState().Accepted.Num() >= 2;
+	});
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, sink, spoolFilename, first, second]() mutable {
+		const FMetricsTestHttpServer::FState& state = server->GetState();
+		TestEqual(TEXT("Each batch is accepted once"), state.Accepted.Num(), 2);
+		if (state.Accepted.Num() == 2) {
+			TestEqual(TEXT("The spooled batch is delivered first"), state.Accepted[0], FString(first));
+			TestEqual(TEXT("The newer batch is delivered after it"), state.Accepted[1], FString(second));
+		}
+		TestEqual(TEXT("The first batch was retried until it got through"), state.NumRequests, 4);
+
+		sink.Reset();
+		TestFalse(TEXT("The spool is deleted once replayed"), FPlatformFileManager::Get().GetPlatformFile().FileExists(*spoolFilename));
+		return true;
+	}));
+
+	return true;
+}
+
+#endif // WITH_METRICS_TEST_HTTP_SERVER
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_METRICS_TEST_HTTP_SERVER
+
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Compression.h"
+
+#include "MetricsSettingsSnapshot.h"
+
+/**
+ * Stand-in for an InfluxDB write endpoint in automation tests.
+ *
+ * Listens on localhost and answers each write with the next code from the given responses, or 204 once they run out,
+ * keeping the decompressed body of every write it accepted. Requests are served on the game thread, so tests wait for
+ * them with latent commands.
+ */
+class FMetricsTestHttpServer
+{
+public:
+	static const uint32 PORT = 18086;
+
+	struct FState
+	{
+		TArray<int32> Responses;
+		TArray<FString> Accepted;
+		int32 NumRequests{ 0 };
+		int32 NumCompressed{ 0 };
+	};
+
+	FMetricsTestHttpServer(const TArray<int32>& InResponses)
+		: State(MakeShared<FState>())
+	{
+		State->Responses = InResponses;
+
+		Router = FHttpServerModule::Get().GetHttpRouter(PORT);
+		if (!Router.IsValid()) return;
+
+		TSharedRef<FState> state = State;
+		Handle = Router->BindRoute(FHttpPath(TEXT("/write")), EHttpServerRequestVerbs::VERB_POST,
+			[state](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete) {
+				state->NumRequests++;
+				const int32 code = state->Responses.Num() > 0 ? state->Responses[0] : 204;
+				if (state->Responses.Num() > 0) {
+					state->Responses.RemoveAt(0);
+				}
+
+				if (code < 300) {
+					TArray<uint8> body;
+					if (IsGzip(Request)) {
+						state->NumCompressed++;
+						Decompress(Request.Body, body);
+					}
+					else {
+						body = Request.Body;
+					}
+					body.Add(0);
+					state->Accepted.Add(UTF8_TO_TCHAR((const ANSICHAR*)body.GetData()));
+				}
+
+				TUniquePtr<FHttpServerResponse> response = MakeUnique<FHttpServerResponse>();
+				response->Code = (EHttpServerResponseCodes)code;
+				OnComplete(MoveTemp(response));
+				return true;
+			});
+		FHttpServerModule::Get().StartAllListeners();
+	}
+
+	~FMetricsTestHttpServer()
+	{
+		if (Router.IsValid() && Handle.IsValid()) {
+			Router->UnbindRoute(Handle);
+		}
+	}
+
+	bool IsListening() const { return Handle.IsValid(); }
+
+	const FState& GetState() const { return *State; }
+
+	// Settings that send everything to this server, retrying failed batches quickly
+	FMetricsSettingsRef MakeSettings(bool bCompress) const
+	{
+		TSharedRef<FMetricsSettingsSnapshot, ESPMode::ThreadSafe> settings = MakeShared<FMetricsSettingsSnapshot, ESPMode::ThreadSafe>();
+		settings->EnableLogging = true;
+		settings->Precision = TimestampPrecision::Nanoseconds;
+		settings->bInfluxConfigured = true;
+		for (int32 precision = 0; precision < NUM_TIMESTAMP_PRECISIONS; precision++) {
+			settings->InfluxWriteUrls[precision] = FString::Printf(TEXT("http://127.0.0.1:%u/write?db=test"), PORT);
+		}
+		settings->InfluxRequestTimeout = 5.0f;
+		settings->CompressRequests = bCompress;
+		settings->CompressionMinBytes = 0;
+		settings->RetryMinDelay = 0.1f;
+		settings->RetryMaxDelay = 0.2f;
+		settings->CircuitBreakerThreshold = 100;
+		settings->BatchMaxLatency = 0.1;
+		return settings;
+	}
+
+private:
+	static bool IsGzip(const FHttpServerRequest& Request)
+	{
+		for (const TPair<FString, TArray<FString>>& header : Request.Headers) {
+			if (header.Key.Equals(TEXT("Content-Encoding"), ESearchCase::IgnoreCase)) {
+				return header.Value.Contains(TEXT("gzip"));
+			}
+		}
+		return false;
+	}
+
+	// The uncompressed size is in the last four bytes of a gzip stream
+	static void Decompress(const TArray<uint8>& Compressed, TArray<uint8>& OutBody)
+	{
+		if (Compressed.Num() < 4) return;
+
+		const int32 size = Compressed[Compressed.Num() - 4] | Compressed[Compressed.Num() - 3] << 8 | Compressed[Compressed.Num() - 2] << 16 | Compressed[Compressed.Num() - 1] << 24;
+		OutBody.SetNumUninitialized(size);
+		if (!FCompression::UncompressMemory(NAME_Gzip, OutBody.GetData(), size, Compressed.GetData(), Compressed.Num())) {
+			OutBody.Reset();
+		}
+	}
+
+	TSharedRef<FState> State;
+	TSharedPtr<IHttpRouter> Router;
+	FHttpRouteHandle Handle;
+};
+
+// Waits for Predicate to be true, failing the test if it takes longer than Timeout seconds
+inline void AddMetricsTestWait(FAutomationTestBase* Test, const TCHAR* Description, double Timeout, TFunction<bool()> Predicate)
+{
+	double deadline = 0.0;
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Test, Description, Timeout, Predicate, deadline]() mutable {
+		if (deadline == 0.0) {
+			deadline = FPlatformTime::Seconds() + Timeout;
+		}
+		if (Predicate()) return true;
+		if (FPlatformTime::Seconds() < deadline) return false;
+
+		Test->AddError(FString::Printf(TEXT("Timed out waiting for %s."), Description));
+		return true;
+	}));
+}
+
+#endif
@@ -0,0 +1,221 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "UdpSink.h"
+#include "LineProtocolWriter.h"
+#include "MetricsClock.h"
+#include "MetricsLogCategory.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+FUdpSink::FUdpSink()
+	: IMetricsSink(TEXT("Udp"), GetDefault<UMetricsLoggerSettings>()->SinkQueueCapacity, GetDefault<UMetricsLoggerSettings>()->UdpBackpressure)
+{
+	const UMetricsLoggerSettings* SinkSettings = GetDefault<UMetricsLoggerSettings>();
+	Format = SinkSettings->UdpFormat;
+	MaxDatagramBytes = SinkSettings->UdpMaxDatagramBytes;
+	Prefix = SinkSettings->UdpPrefix;
+	Datagram.Reserve(MaxDatagramBytes);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem) {
+		// Resolved once up front - the listener is expected to stay where it is
+		FAddressInfoResult result = SocketSubsystem->GetAddressInfo(*SinkSettings->UdpHost, nullptr, EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Datagram);
+		if (result.ReturnCode == SE_NO_ERROR && result.Results.Num() > 0) {
+			Address = result.Results[0].Address;
+			Address->SetPort(SinkSettings->UdpPort);
+			Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("MetricsLogger UDP sink"), Address->GetProtocolType());
+		}
+	}
+
+	if (!Socket) {
+		UE_LOG(MetricsLog, Error, TEXT("Could not open a UDP socket to %s:%d - metrics won't be sent there."), *SinkSettings->UdpHost, SinkSettings->UdpPort);
+	}
+
+	NextFlushTime = FPlatformTime::Seconds() + Settings->UdpFlushInterval;
+	StartThread();
+}
+
+FUdpSink::~FUdpSink()
+{
+	StopThread();
+
+	if (Socket) {
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+void FUdpSink::Write(const FMetricsBatch& Batch)
+{
+	Tags = Batch.Tags;
+
+	for (const EventMetaData& data : Batch.Events) {
+		// The pipeline's summaries, internal stats and custom metrics are aggregates already
+		if (MetricsLoggerUtils::IsAggregateEvent(data.type)) continue;
+
+		const uint32 key = ((uint32)data.type << 1) | (data.success ? 1 : 0);
+
+		FAggregate* aggregate = Aggregates.Find(key);
+		if (!aggregate) {
+			aggregate = &Aggregates.Add(key);
+			aggregate->Type = data.type;
+			aggregate->bSuccess = data.success;
+		}
+
+		aggregate->Durations.Record(data.duration);
+
+		// Field names are string literals, so the latest value of each is found by pointer
+		for (int32 i = 0; i < data.numFields; i++) {
+			EventField* gauge = aggregate->Gauges.FindByPredicate([&](const EventField& field) { return field.name == data.fields[i].name; });
+			if (gauge) {
+				gauge->value = data.fields[i].value;
+			}
+			else {
+				aggregate->Gauges.Add(data.fields[i]);
+			}
+		}
+	}
+}
+
+void FUdpSink::Update()
+{
+	if (FPlatformTime::Seconds() >= NextFlushTime) {
+		SendAggregates();
+	}
+}
+
+void FUdpSink::OnFlush()
+{
+	SendAggregates();
+}
+
+void FUdpSink::SendAggregates()
+{
+	NextFlushTime = FPlatformTime::Seconds() + Settings->UdpFlushInterval;
+	if (Aggregates.Num() == 0) return;
+
+	const int64 timestamp = FMetricsClock::Now();
+	for (const TPair<uint32, FAggregate>& aggregate : Aggregates) {
+		if (Format == UdpSinkFormat::StatsD) {
+			AddStatsDLines(aggregate.Value);
+		}
+		else {
+			TArray<uint8> line;
+			AppendLineProtocol(aggregate.Value, timestamp, line);
+			AddLine(line);
+		}
+	}
+	SendDatagram();
+
+	Aggregates.Reset();
+}
+
+void FUdpSink::AddStatsDLines(const FAggregate& Aggregate)
+{
+	// <prefix>.<measurement>.<success|failure>.<metric>:<value>|<type>, one metric per line
+	TArray<uint8> name;
+	FLineProtocolWriter::AppendMeasurement(name, Prefix);
+	name.Add('.');
+	FLineProtocolWriter::AppendMeasurement(name, MetricsLoggerUtils::LogEventTypeToFString(Aggregate.Type));
+	Aggregate.bSuccess ? FLineProtocolWriter::AppendLiteral(name, ".success.") : FLineProtocolWriter::AppendLiteral(name, ".failure.");
+
+	TArray<uint8> line;
+	auto AppendMetric = [&](const ANSICHAR* metric, double value, const ANSICHAR* type) {
+		line.Reset();
+		line.Append(name);
+		line.Append((const uint8*)metric, FCStringAnsi::Strlen(metric));
+		line.Add(':');
+		FLineProtocolWriter::AppendDouble(line, value);
+		line.Add('|');
+		line.Append((const uint8*)type, FCStringAnsi::Strlen(type));
+		AddLine(line);
+	};
+
+	// StatsD tools expect timings in milliseconds, so the duration gauges are sent in milliseconds and say so in their
+	// names - the line protocol format keeps seconds like every other duration the logger writes to InfluxDB
+	const FMetricsHistogram& durations = Aggregate.Durations;
+	AppendMetric("count", durations.GetCount(), "c");
+	AppendMetric("duration_mean_ms", durations.GetMean() * 1000.0, "g");
+	AppendMetric("duration_min_ms", durations.GetMin() * 1000.0, "g");
+	AppendMetric("duration_p50_ms", durations.GetPercentile(50.0) * 1000.0, "g");
+	AppendMetric("duration_p90_ms", durations.GetPercentile(90.0) * 1000.0, "g");
+	AppendMetric("duration_p99_ms", durations.GetPercentile(99.0) * 1000.0, "g");
+	AppendMetric("duration_max_ms", durations.GetMax() * 1000.0, "g");
+	for (const EventField& gauge : Aggregate.Gauges) {
+		AppendMetric(gauge.name, gauge.value, "g");
+	}
+}
+
+void FUdpSink::AppendLineProtocol(const FAggregate& Aggregate, int64 Timestamp, TArray<uint8>& Line) const
+{
+	// <prefix>_<measurement>,<tags>,success=<True|False> count=..,duration_p50=..,<fields> <timestamp in ns>
+	FLineProtocolWriter::AppendMeasurement(Line, Prefix + TEXT("_") + MetricsLoggerUtils::LogEventTypeToFString(Aggregate.Type));
+	if (Tags.IsValid()) {
+		for (const TPair<FString, FString>& tag : *Tags) {
+			Line.Add(',');
+			FLineProtocolWriter::AppendTag(Line, tag.Key);
+			Line.Add('=');
+			FLineProtocolWriter::AppendTag(Line, tag.Value.IsEmpty() ? TEXT("N/A") : tag.Value);
+		}
+	}
+	Aggregate.bSuccess ? FLineProtocolWriter::AppendLiteral(Line, ",success=True count=") : FLineProtocolWriter::AppendLiteral(Line, ",success=False count=");
+	const FMetricsHistogram& durations = Aggregate.Durations;
+	FLineProtocolWriter::AppendInteger(Line, durations.GetCount());
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_mean=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetMean());
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_min=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetMin());
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_p50=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetPercentile(50.0));
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_p90=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetPercentile(90.0));
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_p99=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetPercentile(99.0));
+	FLineProtocolWriter::AppendLiteral(Line, ",duration_max=");
+	FLineProtocolWriter::AppendDouble(Line, durations.GetMax());
+	for (const EventField& gauge : Aggregate.Gauges) {
+		Line.Add(',');
+		Line.Append((const uint8*)gauge.name, FCStringAnsi::Strlen(gauge.name));
+		Line.Add('=');
+		FLineProtocolWriter::AppendDouble(Line, gauge.value);
+	}
+	Line.Add(' ');
+	FLineProtocolWriter::AppendInteger(Line, Timestamp);
+}
+
+void FUdpSink::AddLine(const TArray<uint8>& Line)
+{
+	// Lines are newline separated within a datagram, a line too long for a datagram of its own is sent by itself
+	if (Datagram.Num() > 0 && Datagram.Num() + 1 + Line.Num() > MaxDatagramBytes) {
+		SendDatagram();
+	}
+	if (Datagram.Num() > 0) {
+		Datagram.Add('\n');
+	}
+	Datagram.Append(Line);
+}
+
+void FUdpSink::SendDatagram()
+{
+	if (Datagram.Num() == 0) return;
+
+	int32 bytesSent = 0;
+	if (Socket && !Socket->SendTo(Datagram.GetData(), Datagram.Num(), bytesSent, *Address)) {
+		UE_LOG(MetricsLog, Verbose, TEXT("Could not send a %d byte metrics datagram."), Datagram.Num());
+	}
+	Datagram.Reset();
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2021-2022 Wargaming.net. All rights reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Parent Class
+#include "IMetricsSink.h"
+#include "MetricsHistogram.h"
+#include "MetricsSettingsSnapshot.h"
+
+class FInternetAddr;
+class FSocket;
+
+/**
+ * Fire-and-forget sink that sends aggregated metrics to a StatsD or InfluxDB UDP listener.
+ *
+ * Events aren't sent one by one. Over each flush interval they are aggregated per event type and success into an
+ * event counter, a histogram of the durations and the latest value of each field, and only the aggregates are sent.
+ * The lines are packed into datagrams no larger than the configured size so they aren't fragmented on the way.
+ */
+class FUdpSink: public IMetricsSink
+{
+public:
+	FUdpSink();
+	virtual ~FUdpSink();
+
+protected:
+	// IMetricsSink overrides
+	virtual void Write(const FMetricsBatch& Batch) override;
+	virtual void Update() override;
+	virtual void OnFlush() override;
+
+private:
+	struct FAggregate
+	{
+		LogEventTypeEnum Type;
+		bool bSuccess;
+		FMetricsHistogram Durations;
+		TArray<EventField> Gauges;
+	};
+
+	void SendAggregates();
+	void AddStatsDLines(const FAggregate& Aggregate);
+	void AppendLineProtocol(const FAggregate& Aggregate, int64 Timestamp, TArray<uint8>& Line) const;
+
+	// Adds a line to the datagram, sending the datagram first if the line doesn't fit
+	void AddLine(const TArray<uint8>& Line);
+	void SendDatagram();
+
+	UdpSinkFormat Format;
+	int32 MaxDatagramBytes;
+	FString Prefix;
+
+	// Flush interval for the sink thread
+	FMetricsSettingsCache Settings;
+
+	FSocket* Socket{ nullptr };
+	TSharedPtr<FInternetAddr> Address;
+
+	// Aggregates since the last flush, by event type and success
+	TMap<uint32, FAggregate> Aggregates;
+	TSharedPtr<const FMetricsTags, ESPMode::ThreadSafe> Tags;
+	double NextFlushTime{ 0.0 };
+
+	// Datagram being filled
+	TArray<uint8> Datagram;
+};
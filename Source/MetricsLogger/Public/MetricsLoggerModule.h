@@ -14,12 +14,112 @@
 
 #pragma once
 
+#include "HAL/PlatformTime.h"
 #include "Modules/ModuleManager.h"
 #include "Templates/UniquePtr.h"
 
 class FMetricsLoggerEventMonitor;
 class IMetricsLogger;
 
+// What a metric recorded through the METRICS_ macros measures
+enum class EMetricKind : uint8
+{
+	// Durations, logged with their count and percentiles
+	Timer,
+	// Amounts added up over each interval
+	Counter,
+	// The latest value set in each interval
+	Gauge
+};
+
+struct FMetricDescriptor;
+
+/**
+ * Records metrics from any thread for the logger to pick up.
+ *
+ * Each thread aggregates what it records in a buffer of its own that the logger swaps out once per interval, so
+ * recording takes no locks and never drops a value. It only allocates the first time a thread records a metric, or a
+ * longer duration than it has seen before.
+ */
+class METRICSLOGGER_API FMetricsRecorder
+{
+public:
+	static void RecordTime(const FMetricDescriptor& Descriptor, uint64 Cycles);
+	static void RecordValue(const FMetricDescriptor& Descriptor, double Value);
+
+	// Registers a use site of a metric and returns the id of its name and kind. The name is copied.
+	static uint32 RegisterMetric(const ANSICHAR* Name, EMetricKind Kind);
+	static void UnregisterMetric(uint32 Id);
+};
+
+/**
+ * A metric as seen from one use site. The METRICS_ macros declare one per site, which registers the metric when it
+ * is constructed and unregisters it when it is destroyed, so adding a metric needs nothing set up with the logger
+ * and the logger keeps nothing owned by the module that declared it once that module unloads.
+ * Sites sharing a name and kind are logged together as one custom_metric point. Names are compared ignoring case.
+ */
+struct FMetricDescriptor
+{
+	FMetricDescriptor(const ANSICHAR* Name, EMetricKind InKind)
+		: Id(FMetricsRecorder::RegisterMetric(Name, InKind))
+		, Kind(InKind)
+	{
+	}
+
+	~FMetricDescriptor()
+	{
+		FMetricsRecorder::UnregisterMetric(Id);
+	}
+
+	FMetricDescriptor(const FMetricDescriptor&) = delete;
+	FMetricDescriptor& operator=(const FMetricDescriptor&) = delete;
+
+	// Stays the same for the name and kind while the logger is loaded, even across unregistering
+	const uint32 Id;
+	const EMetricKind Kind;
+};
+
+/**
+ * Records the time from its construction to the end of the scope.
+ */
+class FMetricsScopedTimer
+{
+public:
+	explicit FMetricsScopedTimer(const FMetricDescriptor& InDescriptor)
+		: Descriptor(InDescriptor)
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+	}
+
+	~FMetricsScopedTimer()
+	{
+		FMetricsRecorder::RecordTime(Descriptor, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	const FMetricDescriptor& Descriptor;
+	uint64 StartCycles;
+};
+
+// Times the rest of the enclosing scope
+#define METRICS_SCOPED_TIMER(Name) \
+	static const FMetricDescriptor PREPROCESSOR_JOIN(MetricsDescriptor, __LINE__){ Name, EMetricKind::Timer }; \
+	FMetricsScopedTimer PREPROCESSOR_JOIN(MetricsScopedTimer, __LINE__)(PREPROCESSOR_JOIN(MetricsDescriptor, __LINE__))
+
+// Adds Amount to a counter
+#define METRICS_COUNTER_ADD(Name, Amount) \
+	do { \
+		static const FMetricDescriptor MetricsDescriptor{ Name, EMetricKind::Counter }; \
+		FMetricsRecorder::RecordValue(MetricsDescriptor, (double)(Amount)); \
+	} while (0)
+
+// Sets a gauge to Value
+#define METRICS_GAUGE_SET(Name, Value) \
+	do { \
+		static const FMetricDescriptor MetricsDescriptor{ Name, EMetricKind::Gauge }; \
+		FMetricsRecorder::RecordValue(MetricsDescriptor, (double)(Value)); \
+	} while (0)
+
 class FMetricsLoggerModule : public IModuleInterface
 {
 public: